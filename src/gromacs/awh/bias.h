@@ -221,11 +221,14 @@ class Bias
          * sense as a relative, to other coordinate values, measure of the bias.
          *
          * \param[in] coordValue  The coordinate value.
+         * \param[in,out] neighborsBuffer  When not nullptr, used to generate the neighbor
+         *                                 list without storing it in the grid.
          * \returns the convolved bias >= -GMX_FLOAT_MAX.
          */
-        double calcConvolvedBias(const awh_dvec &coordValue) const
+        double calcConvolvedBias(const awh_dvec   &coordValue,
+                                 std::vector<int> *neighborsBuffer = nullptr) const
         {
-            return state_.calcConvolvedBias(dimParams_, grid_, coordValue);
+            return state_.calcConvolvedBias(dimParams_, grid_, coordValue, neighborsBuffer);
         }
 
         /*! \brief
@@ -202,44 +202,109 @@ double freeEnergyMinimumValue(gmx::ArrayRef<const PointState> pointState)
     return fMin;
 }
 
+#if GMX_SIMD_HAVE_DOUBLE
+//! SIMD or scalar type used for evaluating probability weights.
+typedef SimdDouble PackType;
+//! The number of probability weights evaluated at once.
+constexpr int      c_packSize = GMX_SIMD_DOUBLE_WIDTH;
+#else
+//! SIMD or scalar type used for evaluating probability weights.
+typedef double     PackType;
+//! The number of probability weights evaluated at once.
+constexpr int      c_packSize = 1;
+#endif
+
 /*! \brief
- * Find and return the log of the probability weight of a point given a coordinate value.
+ * Computes the probability weights of a set of points given a coordinate value.
  *
- * The unnormalized weight is given by
+ * The unnormalized weight of a point is given by
  * w(point|value) = exp(bias(point) - U(value,point)),
  * where U is a harmonic umbrella potential.
+ * Points outside of the target region get zero weight.
+ *
+ * The work is done in packs of c_packSize points: the bias and coordinates
+ * of the points in a pack are gathered into aligned buffers and the
+ * umbrella potential and the exponential are evaluated with SIMD.
+ * The dimension parameters are hoisted out of the loop over the points.
  *
- * \param[in] dimParams     The bias dimensions parameters
- * \param[in] points        The point state.
- * \param[in] grid          The grid.
- * \param[in] pointIndex    Point to evaluate probability weight for.
- * \param[in] pointBias     Bias for the point (as a log weight).
- * \param[in] value         Coordinate value.
- * \returns the log of the biased probability weight.
+ * \param[in]  dimParams     The bias dimensions parameters
+ * \param[in]  points        The point state.
+ * \param[in]  grid          The grid.
+ * \param[in]  pointIndices  The points to compute the weight for.
+ * \param[in]  pointBias     Function returning the bias (as a log weight) for a point index.
+ * \param[in]  value         Coordinate value.
+ * \param[out] weight        The weights, \p pointIndices.size() rounded up to c_packSize,
+ *                           with zero in the padding (can be nullptr).
+ * \returns the sum of the weights.
  */
-double biasedLogWeightFromPoint(const std::vector<DimParams>  &dimParams,
-                                const std::vector<PointState> &points,
-                                const Grid                    &grid,
-                                int                            pointIndex,
-                                double                         pointBias,
-                                const awh_dvec                 value)
+template<typename BiasFunction>
+double calcProbabilityWeights(const std::vector<DimParams>  &dimParams,
+                              const std::vector<PointState> &points,
+                              const Grid                    &grid,
+                              gmx::ArrayRef<const int>       pointIndices,
+                              const BiasFunction            &pointBias,
+                              const awh_dvec                 value,
+                              double * gmx_restrict          weight)
 {
-    double logWeight = detail::c_largeNegativeExponent;
+    const int numDim = dimParams.size();
 
-    /* Only points in the target reigon have non-zero weight */
-    if (points[pointIndex].inTargetRegion())
+    PackType  valuePack[c_biasMaxNumDim];
+    PackType  periodPack[c_biasMaxNumDim];
+    PackType  halfPeriodPack[c_biasMaxNumDim];
+    PackType  halfBetakPack[c_biasMaxNumDim];
+    for (int d = 0; d < numDim; d++)
     {
-        logWeight = pointBias;
+        const double period = grid.axis(d).period();
+        valuePack[d]        = PackType(value[d]);
+        periodPack[d]       = PackType(period);
+        halfPeriodPack[d]   = PackType(0.5*period);
+        halfBetakPack[d]    = PackType(0.5*dimParams[d].betak);
+    }
+
+    alignas(GMX_SIMD_ALIGNMENT) double biasBuffer[c_packSize];
+    alignas(GMX_SIMD_ALIGNMENT) double inTargetBuffer[c_packSize];
+    alignas(GMX_SIMD_ALIGNMENT) double coordBuffer[c_biasMaxNumDim][c_packSize];
+
+    const int                          numPoints = pointIndices.ssize();
+    PackType                           weightSumPack(0.0);
+    for (int i = 0; i < numPoints; i += c_packSize)
+    {
+        /* Gather the point data, pad with values that don't affect the result */
+        for (int n = 0; n < c_packSize; n++)
+        {
+            const int  pointIndex = (i + n < numPoints ? pointIndices[i + n] : -1);
+            const bool inTarget   = (pointIndex >= 0 && points[pointIndex].inTargetRegion());
+            biasBuffer[n]         = inTarget ? pointBias(pointIndex) : 0;
+            inTargetBuffer[n]     = inTarget ? 1 : 0;
+            for (int d = 0; d < numDim; d++)
+            {
+                coordBuffer[d][n] = inTarget ? grid.point(pointIndex).coordValue[d] : value[d];
+            }
+        }
 
+        PackType logWeight = load<PackType>(biasBuffer);
         /* Add potential for all parameter dimensions */
-        for (size_t d = 0; d < dimParams.size(); d++)
+        for (int d = 0; d < numDim; d++)
+        {
+            PackType dev = valuePack[d] - load<PackType>(coordBuffer[d]);
+            /* Center periodic deviations around zero, adds zero for non-periodic axes */
+            dev          = dev - selectByMask(periodPack[d], halfPeriodPack[d] <= dev);
+            dev          = dev + selectByMask(periodPack[d], dev < -halfPeriodPack[d]);
+            logWeight    = logWeight - halfBetakPack[d]*dev*dev;
+        }
+
+        /* Only points in the target region have non-zero weight */
+        logWeight = blend(PackType(detail::c_largeNegativeExponent), logWeight,
+                          PackType(0.0) < load<PackType>(inTargetBuffer));
+        PackType weightPack = gmx::exp(logWeight);
+        weightSumPack       = weightSumPack + weightPack;
+        if (weight != nullptr)
         {
-            double dev = getDeviationFromPointAlongGridAxis(grid, d, pointIndex, value[d]);
-            logWeight -= 0.5*dimParams[d].betak*dev*dev;
+            store(weight + i, weightPack);
         }
     }
 
-    return logWeight;
+    return reduce(weightSumPack);
 }
 
 }   // namespace
@@ -256,23 +321,22 @@ void BiasState::calcConvolvedPmf(const std::vector<DimParams>  &dimParams,
     std::vector<float> pmf(numPoints);
     getPmf(pmf);
 
+    /* The negative PMF is a positive bias. */
+    auto biasFromPmf = [&pmf](int pointIndex) { return -static_cast<double>(pmf[pointIndex]); };
+
+    /* We loop over all points once, so we don't store their neighbor lists */
+    std::vector<int> neighbors;
     for (size_t m = 0; m < numPoints; m++)
     {
-        double           freeEnergyWeights = 0;
         const GridPoint &point             = grid.point(m);
-        for (auto &neighbor : point.neighbor)
-        {
-            /* The negative PMF is a positive bias. */
-            double biasNeighbor = -pmf[neighbor];
-
-            /* Add the convolved PMF weights for the neighbors of this point.
-               Note that this function only adds point within the target > 0 region.
-               Sum weights, take the logarithm last to get the free energy. */
-            double logWeight   = biasedLogWeightFromPoint(dimParams, points_, grid,
-                                                          neighbor, biasNeighbor,
-                                                          point.coordValue);
-            freeEnergyWeights += std::exp(logWeight);
-        }
+        grid.getNeighbors(m, &neighbors);
+
+        /* Add the convolved PMF weights for the neighbors of this point.
+           Note that this function only adds point within the target > 0 region.
+           Sum weights, take the logarithm last to get the free energy. */
+        double           freeEnergyWeights =
+            calcProbabilityWeights(dimParams, points_, grid, neighbors,
+                                   biasFromPmf, point.coordValue, nullptr);
 
         GMX_RELEASE_ASSERT(freeEnergyWeights > 0, "Attempting to do log(<= 0) in AWH convolved PMF calculation.");
         (*convolvedPmf)[m] = -std::log(static_cast<float>(freeEnergyWeights));
@@ -372,16 +436,17 @@ int BiasState::warnForHistogramAnomalies(const Grid  &grid,
     double invNormWeight = 1.0/sumWeights;
 
     /* Check all points for warnings */
-    int         numWarnings  = 0;
-    size_t      numPoints    = grid.numPoints();
+    int              numWarnings  = 0;
+    size_t           numPoints    = grid.numPoints();
+    std::vector<int> neighbors;
     for (size_t m = 0; m < numPoints; m++)
     {
         /* Skip points close to boundary or non-target region */
-        const GridPoint &gridPoint = grid.point(m);
+        grid.getNeighbors(m, &neighbors);
         bool             skipPoint = false;
-        for (size_t n = 0; (n < gridPoint.neighbor.size()) && !skipPoint; n++)
+        for (size_t n = 0; (n < neighbors.size()) && !skipPoint; n++)
         {
-            int neighbor = gridPoint.neighbor[n];
+            int neighbor = neighbors[n];
             skipPoint    = !points_[neighbor].inTargetRegion();
             for (int d = 0; (d < grid.numDimensions()) && !skipPoint; d++)
             {
@@ -453,7 +518,7 @@ void BiasState::calcConvolvedForce(const std::vector<DimParams> &dimParams,
     }
 
     /* Only neighboring points have non-negligible contribution. */
-    const std::vector<int> &neighbor          = grid.point(coordState_.gridpointIndex()).neighbor;
+    const std::vector<int> &neighbor          = grid.neighbors(coordState_.gridpointIndex());
     gmx::ArrayRef<double>   forceFromNeighbor = forceWorkBuffer;
     for (size_t n = 0; n < neighbor.size(); n++)
     {
@@ -598,7 +663,7 @@ void BiasState::doSkippedUpdatesInNeighborhood(const BiasParams &params,
     getSkippedUpdateHistogramScaleFactors(params, &weightHistScaling, &logPmfsumScaling);
 
     /* For each neighbor point of the center point, refresh its state by adding the results of all past, skipped updates. */
-    const std::vector<int> &neighbors = grid.point(coordState_.gridpointIndex()).neighbor;
+    const std::vector<int> &neighbors = grid.neighbors(coordState_.gridpointIndex());
     for (auto &neighbor : neighbors)
     {
         bool didUpdate = points_[neighbor].performPreviouslySkippedUpdates(params, histogramSize_.numUpdates(), weightHistScaling, logPmfsumScaling);
@@ -1156,45 +1221,18 @@ double BiasState::updateProbabilityWeightsAndConvolvedBias(const std::vector<Dim
                                                            std::vector < double, AlignedAllocator < double>> *weight) const
 {
     /* Only neighbors of the current coordinate value will have a non-negligible chance of getting sampled */
-    const std::vector<int> &neighbors = grid.point(coordState_.gridpointIndex()).neighbor;
+    const std::vector<int> &neighbors = grid.neighbors(coordState_.gridpointIndex());
 
-#if GMX_SIMD_HAVE_DOUBLE
-    typedef SimdDouble PackType;
-    constexpr int packSize = GMX_SIMD_DOUBLE_WIDTH;
-#else
-    typedef double PackType;
-    constexpr int packSize = 1;
-#endif
-    /* Round the size of the weight array up to packSize */
-    const int     weightSize = ((neighbors.size() + packSize - 1)/packSize)*packSize;
+    /* Round the size of the weight array up to the pack size */
+    const int               weightSize = ((neighbors.size() + c_packSize - 1)/c_packSize)*c_packSize;
     weight->resize(weightSize);
 
-    double * gmx_restrict weightData = weight->data();
-    PackType              weightSumPack(0.0);
-    for (size_t i = 0; i < neighbors.size(); i += packSize)
-    {
-        for (size_t n = i; n < i + packSize; n++)
-        {
-            if (n < neighbors.size())
-            {
-                const int neighbor = neighbors[n];
-                (*weight)[n] = biasedLogWeightFromPoint(dimParams, points_, grid,
-                                                        neighbor, points_[neighbor].bias(),
-                                                        coordState_.coordValue());
-            }
-            else
-            {
-                /* Pad with values that don't affect the result */
-                (*weight)[n] = detail::c_largeNegativeExponent;
-            }
-        }
-        PackType weightPack = load<PackType>(weightData + i);
-        weightPack          = gmx::exp(weightPack);
-        weightSumPack       = weightSumPack + weightPack;
-        store(weightData + i, weightPack);
-    }
+    auto                    biasFromState = [this](int pointIndex) { return points_[pointIndex].bias(); };
+
     /* Sum of probability weights */
-    double weightSum    = reduce(weightSumPack);
+    double weightSum    = calcProbabilityWeights(dimParams, points_, grid, neighbors,
+                                                 biasFromState, coordState_.coordValue(),
+                                                 weight->data());
     GMX_RELEASE_ASSERT(weightSum > 0, "zero probability weight when updating AWH probability weights.");
 
     /* Normalize probabilities to sum to 1 */
@@ -1210,20 +1248,24 @@ double BiasState::updateProbabilityWeightsAndConvolvedBias(const std::vector<Dim
 
 double BiasState::calcConvolvedBias(const std::vector<DimParams>  &dimParams,
                                     const Grid                    &grid,
-                                    const awh_dvec                &coordValue) const
+                                    const awh_dvec                &coordValue,
+                                    std::vector<int>              *neighborsBuffer) const
 {
-    int              point      = grid.nearestIndex(coordValue);
-    const GridPoint &gridPoint  = grid.point(point);
+    int                     point     = grid.nearestIndex(coordValue);
 
-    /* Sum the probability weights from the neighborhood of the given point */
-    double weightSum = 0;
-    for (int neighbor : gridPoint.neighbor)
+    /* Without a buffer we use the stored neighbor list of the point,
+     * with a buffer we generate the list without storing it.
+     */
+    if (neighborsBuffer != nullptr)
     {
-        double logWeight = biasedLogWeightFromPoint(dimParams, points_, grid,
-                                                    neighbor, points_[neighbor].bias(),
-                                                    coordValue);
-        weightSum       += std::exp(logWeight);
+        grid.getNeighbors(point, neighborsBuffer);
     }
+    const std::vector<int> &neighbors = (neighborsBuffer != nullptr ? *neighborsBuffer : grid.neighbors(point));
+
+    /* Sum the probability weights from the neighborhood of the given point */
+    auto                    biasFromState = [this](int pointIndex) { return points_[pointIndex].bias(); };
+    double           weightSum     = calcProbabilityWeights(dimParams, points_, grid, neighbors,
+                                                            biasFromState, coordValue, nullptr);
 
     /* Returns -GMX_FLOAT_MAX if no neighboring points were in the target region. */
     return (weightSum > 0) ? std::log(weightSum) : -GMX_FLOAT_MAX;
@@ -1232,7 +1274,7 @@ double BiasState::calcConvolvedBias(const std::vector<DimParams>  &dimParams,
 void BiasState::sampleProbabilityWeights(const Grid                  &grid,
                                          gmx::ArrayRef<const double>  probWeightNeighbor)
 {
-    const std::vector<int> &neighbor = grid.point(coordState_.gridpointIndex()).neighbor;
+    const std::vector<int> &neighbor = grid.neighbors(coordState_.gridpointIndex());
 
     /* Save weights for next update */
     for (size_t n = 0; n < neighbor.size(); n++)
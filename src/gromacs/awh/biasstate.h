@@ -475,11 +475,14 @@ class BiasState
          * \param[in] dimParams   The bias dimensions parameters
          * \param[in] grid        The grid.
          * \param[in] coordValue  Coordinate value.
+         * \param[in,out] neighborsBuffer  When not nullptr, used to generate the neighbor
+         *                                 list without storing it in \p grid.
          * \returns the convolved bias >= -GMX_FLOAT_MAX.
          */
         double calcConvolvedBias(const std::vector<DimParams>  &dimParams,
                                  const Grid                    &grid,
-                                 const awh_dvec                &coordValue) const;
+                                 const awh_dvec                &coordValue,
+                                 std::vector<int>              *neighborsBuffer = nullptr) const;
 
         /*! \brief
          * Fills the given array with PMF values.
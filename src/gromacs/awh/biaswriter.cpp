@@ -325,7 +325,7 @@ BiasWriter::transferPointDataToWriter(AwhOutputEntryType          outputType,
         case AwhOutputEntryType::Bias:
         {
             const awh_dvec &coordValue = bias.getGridCoordValue(pointIndex);
-            block_[b].data()[pointIndex] = bias.state().points()[pointIndex].inTargetRegion() ? bias.calcConvolvedBias(coordValue) : 0;
+            block_[b].data()[pointIndex] = bias.state().points()[pointIndex].inTargetRegion() ? bias.calcConvolvedBias(coordValue, &neighborsBuffer_) : 0;
         }
         break;
         case AwhOutputEntryType::Visits:
@@ -206,6 +206,7 @@ class BiasWriter
     private:
         std::vector<AwhEnergyBlock>       block_;             /**< The data blocks */
         std::map<AwhOutputEntryType, int> outputTypeToBlock_; /**< Start block index for each variable, -1 when variable should not be written */
+        std::vector<int>                  neighborsBuffer_;   /**< Buffer for neighbor lists, to avoid storing them for all points */
 };
 
 }       // namespace gmx
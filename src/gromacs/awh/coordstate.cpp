@@ -138,7 +138,7 @@ CoordState::sampleUmbrellaGridpoint(const Grid                  &grid,
     /* Sample new umbrella reference value from the probability distribution
      * which is defined for the neighboring points of the current coordinate.
      */
-    const std::vector<int> &neighbor = grid.point(gridpointIndex).neighbor;
+    const std::vector<int> &neighbor = grid.neighbors(gridpointIndex);
 
     /* In order to use the same seed for all AWH biases and get independent
        samples we use the index of the bias. */
@@ -51,6 +51,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <utility>
 
 #include "gromacs/math/functions.h"
 #include "gromacs/math/utilities.h"
@@ -722,7 +723,8 @@ GridAxis::GridAxis(double origin, double end,
 }
 
 Grid::Grid(const std::vector<DimParams> &dimParams,
-           const AwhDimParams           *awhDimParams)
+           const AwhDimParams           *awhDimParams) :
+    numStoredNeighbors_(0)
 {
     /* Define the discretization along each dimension */
     awh_dvec period;
@@ -743,16 +745,39 @@ Grid::Grid(const std::vector<DimParams> &dimParams,
     /* Set their values */
     initPoints();
 
-    /* Keep a neighbor list for each point.
-     * Note: could also generate neighbor list only when needed
-     * instead of storing them for each point.
-     */
-    for (size_t m = 0; m < point_.size(); m++)
+    /* The neighbor lists are only generated when needed, see neighbors(). */
+}
+
+const std::vector<int> &Grid::neighbors(int pointIndex) const
+{
+    GMX_ASSERT(pointIndex >= 0 && pointIndex < static_cast<int>(point_.size()), "pointIndex should be in range");
+
+    auto found = neighbors_.find(pointIndex);
+    if (found == neighbors_.end())
     {
-        std::vector<int> *neighbor = &point_[m].neighbor;
+        std::vector<int> neighbors;
+        setNeighborsOfGridPoint(pointIndex, *this, &neighbors);
 
-        setNeighborsOfGridPoint(m, *this, neighbor);
+        /* Bound the memory use by removing all lists when the store is full */
+        if (numStoredNeighbors_ + neighbors.size() > c_maxNumStoredNeighbors)
+        {
+            neighbors_.clear();
+            numStoredNeighbors_ = 0;
+        }
+        numStoredNeighbors_ += neighbors.size();
+        found                = neighbors_.emplace(pointIndex, std::move(neighbors)).first;
     }
+
+    return found->second;
+}
+
+void Grid::getNeighbors(int               pointIndex,
+                        std::vector<int> *neighbors) const
+{
+    GMX_ASSERT(pointIndex >= 0 && pointIndex < static_cast<int>(point_.size()), "pointIndex should be in range");
+
+    neighbors->clear();
+    setNeighborsOfGridPoint(pointIndex, *this, neighbors);
 }
 
 void mapGridToDataGrid(std::vector<int>    *gridpointToDatapoint,
@@ -56,6 +56,8 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "dimparams.h" /* This is needed for awh_dvec */
 
@@ -171,14 +173,12 @@ class GridAxis
  * \brief A point in the grid.
  *
  * A grid point has a coordinate value and a coordinate index of the same dimensionality as the grid.
- * It knows the the linear indices of its neighboring point (which are useful only when handed up to
- * the grid).
+ * The linear indices of its neighboring points are provided by the grid, see Grid::neighbors().
  */
 struct GridPoint
 {
     awh_dvec         coordValue;    /**< Multidimensional coordinate value of this point */
     awh_ivec         index;         /**< Multidimensional point indices */
-    std::vector<int> neighbor;      /**< Linear point indices of the neighboring points */
 };
 
 /*! \internal
@@ -187,6 +187,15 @@ struct GridPoint
  * The grid discretizes a multidimensional space with some given resolution.
  * Each dimension is represented by an axis which sets the spatial extent,
  * point spacing and periodicity of the grid in that direction.
+ *
+ * The neighbor lists of the points are generated lazily, only for the
+ * points for which they are requested through neighbors(). With the scope
+ * cutoff, the number of neighbors grows as 11^ndim, so storing neighbor
+ * lists for all points would make grids with more than 2-3 dimensions
+ * impractical, while in practice only a small subset of the points are
+ * visited by the coordinate during a simulation. The total size of the
+ * stored lists is bounded, so a long run over a large grid does not end up
+ * storing the lists of all points.
  */
 class Grid
 {
@@ -207,6 +216,9 @@ class Grid
         //! Cut-off in sigma for considering points, neglects 4e-8 of the density.
         static constexpr double c_scopeCutoff       = 5.5;
 
+        //! The maximum total number of point indices in the stored neighbor lists, 64 MB.
+        static constexpr size_t c_maxNumStoredNeighbors = 16*1024*1024;
+
         /*! \brief Construct a grid using AWH input parameters.
          *
          * \param[in] dimParams     Dimension parameters including the expected inverse variance of the coordinate living on the grid (determines the grid spacing).
@@ -233,6 +245,41 @@ class Grid
             return point_[pointIndex];
         }
 
+        /*! \brief Returns the neighbors of a point on the grid.
+         *
+         * The neighbor list is generated on first access and stored for
+         * later calls. When storing it would make the stored lists hold
+         * more than c_maxNumStoredNeighbors indices, all stored lists are
+         * removed first. The returned reference is thus only valid until
+         * the next call of this method.
+         * This method is not thread safe, also not for concurrent calls
+         * on a const grid. This is fine, since the AWH code is only called
+         * by a single thread on each rank.
+         * When looping over many points only once, use getNeighbors()
+         * instead to avoid storing the lists for all points.
+         *
+         * \param[in] pointIndex  Linear index of the grid point.
+         * \returns a constant reference to the linear point indices of the
+         * neighbors of \p pointIndex.
+         */
+        const std::vector<int> &neighbors(int pointIndex) const;
+
+        /*! \brief Generates the neighbors of a point on the grid without storing them.
+         *
+         * \param[in]  pointIndex  Linear index of the grid point.
+         * \param[out] neighbors   The linear point indices of the neighbors
+         *                         of \p pointIndex.
+         */
+        void getNeighbors(int               pointIndex,
+                          std::vector<int> *neighbors) const;
+
+        /*! \brief Returns the number of points for which a neighbor list is stored.
+         */
+        size_t numStoredNeighborLists() const
+        {
+            return neighbors_.size();
+        }
+
         /*! \brief Returns the dimensionality of the grid.
          *
          * \returns the dimensionality of the grid.
@@ -279,6 +326,10 @@ class Grid
     private:
         std::vector<GridPoint> point_; /**< Points on the grid */
         std::vector<GridAxis>  axis_;  /**< Axes, one for each dimension. */
+        //! Neighbor lists of the points for which they have been requested.
+        mutable std::unordered_map < int, std::vector < int>> neighbors_;
+        //! The total number of point indices stored in \p neighbors_.
+        mutable size_t numStoredNeighbors_;
 };
 
 /*! \endcond */
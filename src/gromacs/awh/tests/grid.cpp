@@ -105,13 +105,16 @@ TEST(gridTest, neighborhood)
     bool haveIncorrectNeighbors  = false;
     bool haveCorrectNumNeighbors = true;
 
+    /* Neighbor lists should only be generated on request */
+    EXPECT_EQ(0U, grid.numStoredNeighborLists());
+
     /* Set up a grid for checking for duplicate neighbors */
     std::vector<bool> isInNeighborhood(grid.numPoints(), false);
 
     /* Checking for all points is overkill, we check every 7th */
     for (size_t i = 0; i < grid.numPoints(); i += 7)
     {
-        const GridPoint &point = grid.point(i);
+        const std::vector<int> &neighbors = grid.neighbors(i);
 
         /* NOTE: This code relies on major-minor index ordering in Grid */
         int    pointIndex0       = i/numPointsDim[1];
@@ -123,12 +126,12 @@ TEST(gridTest, neighborhood)
          */
         int    distanceFromEdge1 = std::min(pointIndex1, numPointsDim[1] - 1 - pointIndex1);
         size_t numNeighbors      = (2*scopeInPoints + 1)*(scopeInPoints + std::min(scopeInPoints, distanceFromEdge1) + 1);
-        if (point.neighbor.size() != numNeighbors)
+        if (neighbors.size() != numNeighbors)
         {
             haveCorrectNumNeighbors = false;
         }
 
-        for (auto &j : point.neighbor)
+        for (auto &j : neighbors)
         {
             if (j >= 0 && j < numPoints)
             {
@@ -166,7 +169,7 @@ TEST(gridTest, neighborhood)
         }
 
         /* Clear the marked points in the checking grid */
-        for (auto &neighbor : point.neighbor)
+        for (auto &neighbor : neighbors)
         {
             if (neighbor >= 0 && neighbor < numPoints)
             {
@@ -179,6 +182,15 @@ TEST(gridTest, neighborhood)
     EXPECT_FALSE(haveDuplicateNeighbors);
     EXPECT_FALSE(haveIncorrectNeighbors);
     EXPECT_TRUE(haveCorrectNumNeighbors);
+
+    /* Only the requested neighbor lists should have been stored */
+    EXPECT_EQ((grid.numPoints() + 6)/7, grid.numStoredNeighborLists());
+
+    /* Generating without storing should give the same neighbors */
+    std::vector<int> neighbors;
+    grid.getNeighbors(7, &neighbors);
+    EXPECT_EQ(grid.neighbors(7), neighbors);
+    EXPECT_EQ((grid.numPoints() + 6)/7, grid.numStoredNeighborLists());
 }
 
 }  // namespace test
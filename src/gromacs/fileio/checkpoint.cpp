@@ -45,6 +45,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
 #include <array>
 #include <memory>
 
@@ -488,7 +489,7 @@ static bool_t listXdrVector(XDR *xd, StatePart part, int ecpt, int nf, int xdrTy
 
     const unsigned int elemSize = sizeOfXdrType(xdrType);
     std::vector<char>  data(nf*elemSize);
-    res = xdr_vector(xd, data.data(), nf, elemSize, xdrProc(xdrType));
+    res = xdr_vector_in_bulk(xd, data.data(), nf, elemSize, xdrProc(xdrType));
 
     if (list != nullptr)
     {
@@ -684,9 +685,7 @@ static int doVectorLow(XDR *xd, StatePart part, int ecpt, int sflags,
         {
             snew(vChar, numElemInTheFile*sizeOfXdrType(xdrTypeInTheFile));
         }
-        res = xdr_vector(xd, vChar,
-                         numElemInTheFile, sizeOfXdrType(xdrTypeInTheFile),
-                         xdrProc(xdrTypeInTheFile));
+        res = xdr_vector_in_bulk(xd, vChar, numElemInTheFile, sizeOfXdrType(xdrTypeInTheFile), xdrProc(xdrTypeInTheFile));
         if (res == 0)
         {
             return -1;
@@ -504,7 +504,7 @@ static int gmx_fio_int_get_file_md5(t_fileio *fio, gmx_off_t offset,
         return -1;
     }
 
-    std::vector<unsigned char> buf(maximumChecksumInputSize);
+    std::vector<unsigned char> buf(readLength);
     // The fread puts the file position back to offset.
     if (static_cast<gmx_off_t>(fread(buf.data(), 1, readLength, fio->fp)) != readLength)
     {
@@ -604,10 +604,18 @@ std::vector<gmx_file_position_t> gmx_fio_get_output_file_positions()
             gmx_fio_int_get_file_position(cur, &outputfiles.back().offset);
             if (!GMX_FAHCORE)
             {
-                outputfiles.back().checksumSize
-                    = gmx_fio_int_get_file_md5(cur,
-                                               outputfiles.back().offset,
-                                               &outputfiles.back().checksum);
+                /* Only recompute the checksum when data was written
+                 * since the last time it was computed.
+                 */
+                if (cur->checksumOffset != outputfiles.back().offset)
+                {
+                    cur->checksumSize   = gmx_fio_int_get_file_md5(cur,
+                                                                   outputfiles.back().offset,
+                                                                   &cur->checksum);
+                    cur->checksumOffset = outputfiles.back().offset;
+                }
+                outputfiles.back().checksumSize = cur->checksumSize;
+                outputfiles.back().checksum     = cur->checksum;
             }
         }
 
@@ -752,6 +760,8 @@ int gmx_fio_seek(t_fileio* fio, gmx_off_t fpos)
     if (fio->fp)
     {
         rc = gmx_fseek(fio->fp, fpos, SEEK_SET);
+        /* Data after fpos might be overwritten, so we can not reuse the checksum */
+        fio->checksumOffset = -1;
     }
     else
     {
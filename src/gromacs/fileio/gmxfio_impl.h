@@ -54,6 +54,8 @@
 
    WARNING WARNING WARNING WARNING */
 
+#include <array>
+
 #include "thread_mpi/lock.h"
 
 #include "gromacs/fileio/xdrf.h"
@@ -71,6 +73,15 @@ struct t_fileio
 
     t_fileio    *next, *prev;          /* next and previous file pointers in the
                                           linked list */
+
+    /* Output file checksum computed for the previous checkpoint. Output files
+       are only appended to, so when the file position has not changed, the
+       checksum of the data before it has not changed either. */
+    gmx_off_t    checksumOffset = -1;  /* file position of the checksum, -1 if none */
+    int          checksumSize   = -1;  /* number of bytes used for the checksum */
+    std::array<unsigned char, 16>
+                 checksum       = {{0}}; /* the cached checksum */
+
     tMPI_Lock_t  mtx;                  /* content locking mutex. This is a fast lock
                                           for performance reasons: in some cases every
                                           single byte that gets read/written requires
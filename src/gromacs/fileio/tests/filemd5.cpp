@@ -119,6 +119,34 @@ TEST_F(FileMD5Test, ReturnsErrorIfFileModeIsWrong)
     EXPECT_EQ(-1, lengthActuallyRead);
 }
 
+TEST_F(FileMD5Test, OutputFileChecksumFollowsWrites)
+{
+    file_ = gmx_fio_open(filename_.c_str(), "w+");
+    std::vector<char> data(1000);
+    std::iota(data.begin(), data.end(), 1);
+    FILE             *fp = gmx_fio_getfp(file_);
+    fwrite(data.data(), sizeof(char), 64, fp);
+
+    auto first  = gmx_fio_get_output_file_positions();
+    auto second = gmx_fio_get_output_file_positions();
+    ASSERT_EQ(1U, first.size());
+    ASSERT_EQ(1U, second.size());
+    EXPECT_EQ(64, first[0].offset);
+    EXPECT_EQ(64, first[0].checksumSize);
+    // Same checksum as computed from scratch on the same data
+    EXPECT_EQ(2111, std::accumulate(first[0].checksum.begin(), first[0].checksum.end(), 0));
+    EXPECT_EQ(first[0].checksumSize, second[0].checksumSize);
+    EXPECT_EQ(first[0].checksum, second[0].checksum);
+
+    // Appending data must update the checksum
+    fwrite(data.data() + 64, sizeof(char), data.size() - 64, fp);
+    auto third = gmx_fio_get_output_file_positions();
+    ASSERT_EQ(1U, third.size());
+    EXPECT_EQ(1000, third[0].offset);
+    EXPECT_EQ(1000, third[0].checksumSize);
+    EXPECT_NE(first[0].checksum, third[0].checksum);
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
@@ -0,0 +1,208 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading tpr files with parts of the data skipped
+ *
+ * Checks that skipping the coordinate and velocity blocks, which
+ * is done by seeking, leaves the file at the same position as reading
+ * them, so that the inputrec and topology after them are read unchanged.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/tpxio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxpreprocess/grompp.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/topology/mtop_lookup.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture that generates a tpr file with coordinates and velocities
+class TpxReadTest : public ::testing::Test
+{
+    protected:
+        //! Generates the tpr file and reads it completely as a reference
+        TpxReadTest()
+        {
+            const std::string mdpName = fileManager_.getTemporaryFilePath("input.mdp");
+            TextWriter::writeFileFromString(mdpName,
+                                            "nsteps = 123\n"
+                                            "rcoulomb = 0.7\n"
+                                            "rvdw = 0.7\n"
+                                            "gen-vel = yes\n"
+                                            "gen-temp = 300\n"
+                                            "gen-seed = 1993\n");
+            tprName_ = fileManager_.getTemporaryFilePath("input.tpr");
+
+            CommandLine caller;
+            caller.append("grompp");
+            caller.addOption("-f", mdpName);
+            caller.addOption("-p", TestFileManager::getInputFilePath("4water.top"));
+            caller.addOption("-c", TestFileManager::getInputFilePath("4water.gro"));
+            caller.addOption("-o", tprName_);
+            caller.addOption("-po", fileManager_.getTemporaryFilePath("output.mdp"));
+            EXPECT_EQ(0, gmx_grompp(caller.argc(), caller.argv()));
+
+            read_tpx_state(tprName_.c_str(), &referenceIr_, &referenceState_, &referenceMtop_);
+        }
+
+        //! Checks that \p ir, \p box and \p mtop match the reference
+        void checkMatchesReference(const t_inputrec &ir, const matrix box, const gmx_mtop_t &mtop)
+        {
+            EXPECT_EQ(referenceIr_.nsteps, ir.nsteps);
+            EXPECT_EQ(referenceIr_.rcoulomb, ir.rcoulomb);
+            EXPECT_EQ(referenceIr_.rvdw, ir.rvdw);
+            EXPECT_EQ(referenceIr_.ld_seed, ir.ld_seed);
+            EXPECT_EQ(referenceIr_.opts.ngtc, ir.opts.ngtc);
+            for (int d1 = 0; d1 < DIM; d1++)
+            {
+                for (int d2 = 0; d2 < DIM; d2++)
+                {
+                    EXPECT_EQ(referenceState_.box[d1][d2], box[d1][d2]);
+                }
+            }
+
+            ASSERT_EQ(referenceMtop_.natoms, mtop.natoms);
+            EXPECT_EQ(referenceMtop_.ffparams.numTypes(), mtop.ffparams.numTypes());
+            ASSERT_EQ(referenceMtop_.moltype.size(), mtop.moltype.size());
+            ASSERT_EQ(referenceMtop_.molblock.size(), mtop.molblock.size());
+            for (size_t mb = 0; mb < mtop.molblock.size(); mb++)
+            {
+                EXPECT_EQ(referenceMtop_.molblock[mb].type, mtop.molblock[mb].type);
+                EXPECT_EQ(referenceMtop_.molblock[mb].nmol, mtop.molblock[mb].nmol);
+            }
+            for (int a = 0; a < mtop.natoms; a++)
+            {
+                int            molb    = 0;
+                const t_atom  &atomRef = mtopGetAtomParameters(&referenceMtop_, a, &molb);
+                const t_atom  &atom    = mtopGetAtomParameters(&mtop, a, &molb);
+                EXPECT_EQ(atomRef.q, atom.q);
+                EXPECT_EQ(atomRef.m, atom.m);
+                EXPECT_EQ(atomRef.type, atom.type);
+            }
+        }
+
+        //! Manager for the temporary files
+        TestFileManager fileManager_;
+        //! The name of the tpr file
+        std::string     tprName_;
+        //! The inputrec read with all data
+        t_inputrec      referenceIr_;
+        //! The state read with all data
+        t_state         referenceState_;
+        //! The topology read with all data
+        gmx_mtop_t      referenceMtop_;
+};
+
+TEST_F(TpxReadTest, SkippingCoordinatesAndVelocitiesGivesSameTopology)
+{
+    ASSERT_EQ(referenceState_.flags & (1 << estV), 1 << estV) << "The test needs a tpr file with velocities";
+
+    t_inputrec ir;
+    matrix     box;
+    int        natoms;
+    gmx_mtop_t mtop;
+    read_tpx(tprName_.c_str(), &ir, box, &natoms, nullptr, nullptr, &mtop);
+
+    EXPECT_EQ(referenceState_.natoms, natoms);
+    checkMatchesReference(ir, box, mtop);
+}
+
+TEST_F(TpxReadTest, SkippingVelocitiesGivesSameCoordinatesAndTopology)
+{
+    t_inputrec        ir;
+    matrix            box;
+    int               natoms;
+    gmx_mtop_t        mtop;
+    std::vector<RVec> x(referenceState_.natoms);
+    read_tpx(tprName_.c_str(), &ir, box, &natoms, as_rvec_array(x.data()), nullptr, &mtop);
+
+    ASSERT_EQ(referenceState_.natoms, natoms);
+    for (int a = 0; a < natoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(referenceState_.x[a][d], x[a][d]);
+        }
+    }
+    checkMatchesReference(ir, box, mtop);
+}
+
+TEST_F(TpxReadTest, ReadingCoordinatesAndVelocitiesGivesSameData)
+{
+    t_inputrec        ir;
+    matrix            box;
+    int               natoms;
+    gmx_mtop_t        mtop;
+    std::vector<RVec> x(referenceState_.natoms);
+    std::vector<RVec> v(referenceState_.natoms);
+    read_tpx(tprName_.c_str(), &ir, box, &natoms, as_rvec_array(x.data()), as_rvec_array(v.data()), &mtop);
+
+    ASSERT_EQ(referenceState_.natoms, natoms);
+    for (int a = 0; a < natoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(referenceState_.x[a][d], x[a][d]);
+            EXPECT_EQ(referenceState_.v[a][d], v[a][d]);
+        }
+    }
+    checkMatchesReference(ir, box, mtop);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
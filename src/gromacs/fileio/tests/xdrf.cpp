@@ -0,0 +1,165 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the bulk XDR vector transfers
+ *
+ * Checks that xdr_vector_in_bulk() writes the same byte stream as
+ * xdr_vector() and that a written vector is read back unchanged,
+ * for element counts that do and do not fill whole transfer blocks.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/xdrf.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns the contents of file \p filename
+std::vector<char> readBytes(const std::string &filename)
+{
+    std::vector<char> bytes;
+    FILE             *fp = std::fopen(filename.c_str(), "rb");
+    int               c;
+    while ((c = std::fgetc(fp)) != EOF)
+    {
+        bytes.push_back(static_cast<char>(c));
+    }
+    std::fclose(fp);
+
+    return bytes;
+}
+
+//! Test fixture for bulk XDR transfers, parametrized on the number of elements
+class XdrVectorInBulkTest : public ::testing::TestWithParam<int>
+{
+    protected:
+        /*! \brief Writes \p values with bulk and per-element XDR and reads them back with bulk XDR
+         *
+         * \param[in] values    The values to write
+         * \param[in] elemProc  The XDR function for a single element
+         */
+        template <typename T>
+        void checkRoundTrip(std::vector<T> values, xdrproc_t elemProc)
+        {
+            const int         numElements = values.size();
+            const std::string bulkFile    = fileManager_.getTemporaryFilePath("bulk.xdr");
+            const std::string elemFile    = fileManager_.getTemporaryFilePath("elem.xdr");
+
+            XDR               xdr;
+            FILE             *fp = std::fopen(bulkFile.c_str(), "wb");
+            xdrstdio_create(&xdr, fp, XDR_ENCODE);
+            EXPECT_EQ(1, xdr_vector_in_bulk(&xdr, reinterpret_cast<char *>(values.data()), numElements,
+                                            sizeof(T), elemProc));
+            xdr_destroy(&xdr);
+            std::fclose(fp);
+
+            fp = std::fopen(elemFile.c_str(), "wb");
+            xdrstdio_create(&xdr, fp, XDR_ENCODE);
+            EXPECT_NE(0, xdr_vector(&xdr, reinterpret_cast<char *>(values.data()), numElements,
+                                    sizeof(T), elemProc));
+            xdr_destroy(&xdr);
+            std::fclose(fp);
+
+            EXPECT_EQ(readBytes(elemFile), readBytes(bulkFile));
+
+            std::vector<T> valuesRead(numElements);
+            fp = std::fopen(bulkFile.c_str(), "rb");
+            xdrstdio_create(&xdr, fp, XDR_DECODE);
+            EXPECT_EQ(1, xdr_vector_in_bulk(&xdr, reinterpret_cast<char *>(valuesRead.data()), numElements,
+                                            sizeof(T), elemProc));
+            xdr_destroy(&xdr);
+            std::fclose(fp);
+
+            EXPECT_EQ(values, valuesRead);
+        }
+
+        //! Manager for the temporary files
+        TestFileManager fileManager_;
+};
+
+TEST_P(XdrVectorInBulkTest, IntsRoundTrip)
+{
+    std::vector<int> values;
+    for (int i = 0; i < GetParam(); i++)
+    {
+        values.push_back(i*7919 - 1000000);
+    }
+    checkRoundTrip(values, reinterpret_cast<xdrproc_t>(xdr_int));
+}
+
+TEST_P(XdrVectorInBulkTest, FloatsRoundTrip)
+{
+    std::vector<float> values;
+    for (int i = 0; i < GetParam(); i++)
+    {
+        values.push_back(1.0f/(i + 1) - 0.37f*i);
+    }
+    checkRoundTrip(values, reinterpret_cast<xdrproc_t>(xdr_float));
+}
+
+TEST_P(XdrVectorInBulkTest, DoublesRoundTrip)
+{
+    std::vector<double> values;
+    for (int i = 0; i < GetParam(); i++)
+    {
+        values.push_back(1.0/(i + 3) - 1.23456789e-3*i);
+    }
+    checkRoundTrip(values, reinterpret_cast<xdrproc_t>(xdr_double));
+}
+
+//! Element counts: empty, a single element, odd counts and counts spanning several 64 kB blocks
+const int c_numElements[] = { 0, 1, 7, 8193, 16384, 3*16384 + 5 };
+
+INSTANTIATE_TEST_CASE_P(WithNumElements, XdrVectorInBulkTest, ::testing::ValuesIn(c_numElements));
+
+}  // namespace
+}  // namespace test
+}  // namespace gmx
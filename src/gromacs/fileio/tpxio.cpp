@@ -2583,7 +2583,8 @@ static void do_mtop(t_fileio *fio, gmx_mtop_t *mtop, gmx_bool bRead,
  * If possible, we will read the inputrec even when TopOnlyOK is TRUE.
  */
 static void do_tpxheader(t_fileio *fio, gmx_bool bRead, t_tpxheader *tpx,
-                         gmx_bool TopOnlyOK, int *fileVersionPointer, int *fileGenerationPointer)
+                         gmx_bool TopOnlyOK, int *fileVersionPointer, int *fileGenerationPointer,
+                         int *precisionPointer)
 {
     char      buf[STRLEN];
     char      file_tag[STRLEN];
@@ -2682,6 +2683,10 @@ static void do_tpxheader(t_fileio *fio, gmx_bool bRead, t_tpxheader *tpx,
     {
         *fileGenerationPointer = fileGeneration;
     }
+    if (precisionPointer)
+    {
+        *precisionPointer = precision;
+    }
 
     if ((fileVersion <= tpx_incompatible_version) ||
         ((fileVersion > tpx_version) && !TopOnlyOK) ||
@@ -2719,9 +2724,30 @@ static void do_tpxheader(t_fileio *fio, gmx_bool bRead, t_tpxheader *tpx,
     }
 }
 
+/*! \brief Skips \p n rvecs in a tpx file opened for reading
+ *
+ * This is much faster than decoding them into a dummy buffer,
+ * since the data in the file has a fixed size.
+ */
+static void skipTpxRvecs(t_fileio *fio, int n, int precision)
+{
+    gmx_off_t position = gmx_fio_ftell(fio) + static_cast<gmx_off_t>(n)*DIM*precision;
+    if (gmx_fio_seek(fio, position) != 0)
+    {
+        gmx_file(gmx_fio_getname(fio));
+    }
+}
+
+/*! \brief Reads or writes a tpx file
+ *
+ * When reading with \p x and \p v nullptr, the coordinates and
+ * velocities are read into \p state when \p bReadXVIntoState is set,
+ * and skipped otherwise. When only \p v is nullptr, the velocities
+ * are skipped.
+ */
 static int do_tpx(t_fileio *fio, gmx_bool bRead,
                   t_inputrec *ir, t_state *state, rvec *x, rvec *v,
-                  gmx_mtop_t *mtop)
+                  gmx_mtop_t *mtop, gmx_bool bReadXVIntoState)
 {
     t_tpxheader     tpx;
     gmx_bool        TopOnlyOK;
@@ -2753,13 +2779,14 @@ static int do_tpx(t_fileio *fio, gmx_bool bRead,
 
     int fileVersion;    /* Version number of the code that wrote the file */
     int fileGeneration; /* Generation version number of the code that wrote the file */
-    do_tpxheader(fio, bRead, &tpx, TopOnlyOK, &fileVersion, &fileGeneration);
+    int precision;      /* Size of real in the file */
+    do_tpxheader(fio, bRead, &tpx, TopOnlyOK, &fileVersion, &fileGeneration, &precision);
 
     if (bRead)
     {
         state->flags = 0;
         init_gtc_state(state, tpx.ngtc, 0, 0);
-        if (x == nullptr)
+        if (x == nullptr && bReadXVIntoState)
         {
             // v is also nullptr by the above assertion, so we may
             // need to make memory in state for storing the contents
@@ -2776,7 +2803,7 @@ static int do_tpx(t_fileio *fio, gmx_bool bRead,
         }
     }
 
-    if (x == nullptr)
+    if (x == nullptr && (!bRead || bReadXVIntoState))
     {
         x = state->x.rvec_array();
         v = state->v.rvec_array();
@@ -2834,30 +2861,41 @@ static int do_tpx(t_fileio *fio, gmx_bool bRead,
     do_test(fio, tpx.bX, x);
     if (tpx.bX)
     {
-        if (bRead)
+        if (bRead && x == nullptr)
         {
-            state->flags |= (1<<estX);
+            skipTpxRvecs(fio, tpx.natoms, precision);
+        }
+        else
+        {
+            if (bRead)
+            {
+                state->flags |= (1<<estX);
+            }
+            gmx_fio_ndo_rvec(fio, x, tpx.natoms);
         }
-        gmx_fio_ndo_rvec(fio, x, tpx.natoms);
     }
 
     do_test(fio, tpx.bV, v);
     if (tpx.bV)
     {
-        if (bRead)
+        if (bRead && v == nullptr)
         {
-            state->flags |= (1<<estV);
+            skipTpxRvecs(fio, tpx.natoms, precision);
+        }
+        else
+        {
+            if (bRead)
+            {
+                state->flags |= (1<<estV);
+            }
+            gmx_fio_ndo_rvec(fio, v, tpx.natoms);
         }
-        gmx_fio_ndo_rvec(fio, v, tpx.natoms);
     }
 
     // No need to run do_test when the last argument is NULL
     if (tpx.bF)
     {
-        rvec *dummyForces;
-        snew(dummyForces, state->natoms);
-        gmx_fio_ndo_rvec(fio, dummyForces, tpx.natoms);
-        sfree(dummyForces);
+        skipTpxRvecs(fio, tpx.natoms, precision);
     }
 
     /* Starting with tpx version 26, we have the inputrec
@@ -2961,7 +2999,7 @@ void read_tpxheader(const char *fn, t_tpxheader *tpx, gmx_bool TopOnlyOK)
     t_fileio *fio;
 
     fio = open_tpx(fn, "r");
-    do_tpxheader(fio, TRUE, tpx, TopOnlyOK, nullptr, nullptr);
+    do_tpxheader(fio, TRUE, tpx, TopOnlyOK, nullptr, nullptr, nullptr);
     close_tpx(fio);
 }
 
@@ -2974,7 +3012,7 @@ void write_tpx_state(const char *fn,
     do_tpx(fio, FALSE,
            const_cast<t_inputrec *>(ir),
            const_cast<t_state *>(state), nullptr, nullptr,
-           const_cast<gmx_mtop_t *>(mtop));
+           const_cast<gmx_mtop_t *>(mtop), TRUE);
     close_tpx(fio);
 }
 
@@ -2984,7 +3022,7 @@ void read_tpx_state(const char *fn,
     t_fileio *fio;
 
     fio = open_tpx(fn, "r");
-    do_tpx(fio, TRUE, ir, state, nullptr, nullptr, mtop);
+    do_tpx(fio, TRUE, ir, state, nullptr, nullptr, mtop, TRUE);
     close_tpx(fio);
 }
 
@@ -2997,7 +3035,7 @@ int read_tpx(const char *fn,
     int       ePBC;
 
     fio     = open_tpx(fn, "r");
-    ePBC    = do_tpx(fio, TRUE, ir, &state, x, v, mtop);
+    ePBC    = do_tpx(fio, TRUE, ir, &state, x, v, mtop, FALSE);
     close_tpx(fio);
     if (mtop != nullptr && natoms != nullptr)
     {
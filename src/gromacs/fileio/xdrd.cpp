@@ -36,9 +36,19 @@
  */
 #include "gmxpre.h"
 
+#include "config.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 
 int xdr_real(XDR *xdrs, real *r)
@@ -130,3 +140,92 @@ int xdr_int64(XDR *xdrs, int64_t *i)
 
     return ret;
 }
+
+/*! \brief Reverses the byte order of each element of size \p elemSize in \p data
+ *
+ * Converts between the host and the big-endian XDR representation of
+ * ints, floats and doubles. Does nothing on big-endian hosts.
+ */
+static void convertXdrByteOrder(char *data, int numElements, unsigned int elemSize)
+{
+#if GMX_INTEGER_BIG_ENDIAN
+    GMX_UNUSED_VALUE(data);
+    GMX_UNUSED_VALUE(numElements);
+    GMX_UNUSED_VALUE(elemSize);
+#else
+    for (int i = 0; i < numElements; i++)
+    {
+        std::reverse(data + i*elemSize, data + (i + 1)*elemSize);
+    }
+#endif
+}
+
+/*! \brief Returns whether floats and doubles have the same byte order as integers
+ *
+ * The configuration only tells the integer byte order. As in xdr_double(),
+ * we detect the floating-point layout at run time. Checking the bit
+ * pattern of 1.0 also catches a word order of doubles that differs from
+ * the byte order.
+ */
+static bool floatingPointByteOrderMatchesIntegers()
+{
+    const float   floatValue  = 1.0F;
+    const double  doubleValue = 1.0;
+    std::uint32_t floatBits;
+    std::uint64_t doubleBits;
+    std::memcpy(&floatBits, &floatValue, sizeof(floatBits));
+    std::memcpy(&doubleBits, &doubleValue, sizeof(doubleBits));
+
+    return (floatBits == UINT32_C(0x3F800000) &&
+            doubleBits == UINT64_C(0x3FF0000000000000));
+}
+
+int xdr_vector_in_bulk(XDR *xdrs, char *data, int numElements,
+                       unsigned int elemSize, xdrproc_t elemProc)
+{
+    GMX_ASSERT(elemSize == 4 || elemSize == 8, "Bulk XDR transfers only support elements of 4 or 8 bytes");
+
+    /* The byte order conversion below is the integer one. When the
+     * floating-point layout differs, we let the element function convert.
+     */
+    static const bool canConvertInBulk = floatingPointByteOrderMatchesIntegers();
+
+    if ((xdrs->x_op != XDR_ENCODE && xdrs->x_op != XDR_DECODE) || !canConvertInBulk)
+    {
+        return xdr_vector(xdrs, data, numElements, elemSize, elemProc);
+    }
+
+    /* Use blocks of 64 kB, which is a multiple of the XDR unit of 4 bytes */
+    const int          numElemsPerBlock = 65536/elemSize;
+    std::vector<char>  buffer;
+    if (xdrs->x_op == XDR_ENCODE)
+    {
+        buffer.resize(std::min(numElements, numElemsPerBlock)*elemSize);
+    }
+
+    for (int i = 0; i < numElements; i += numElemsPerBlock)
+    {
+        const int    numElemsInBlock = std::min(numElemsPerBlock, numElements - i);
+        const size_t numBytes        = numElemsInBlock*elemSize;
+        char        *block           = data + i*elemSize;
+        if (xdrs->x_op == XDR_ENCODE)
+        {
+            std::copy(block, block + numBytes, buffer.data());
+            convertXdrByteOrder(buffer.data(), numElemsInBlock, elemSize);
+            if (xdr_opaque(xdrs, buffer.data(), numBytes) == 0)
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            if (xdr_opaque(xdrs, block, numBytes) == 0)
+            {
+                return 0;
+            }
+            convertXdrByteOrder(block, numElemsInBlock, elemSize);
+        }
+    }
+
+    return 1;
+}
@@ -73,6 +73,26 @@ int xdr_int32(XDR *xdrs, int32_t *i);
 //! Read or write a int64_t value.
 int xdr_int64(XDR *xdrs, int64_t *i);
 
+/*! \brief Read or write a vector of ints, floats or doubles in bulk
+ *
+ * Produces the same XDR byte stream as xdr_vector() with \p elemProc,
+ * but converts the byte order of blocks of elements in a buffer and transfers
+ * each block with a single xdr_opaque() call, instead of doing a function
+ * call and a stream operation per element. This matters for large vectors,
+ * such as the state vectors in checkpoint files. On hosts where floats
+ * or doubles do not have the byte order of integers, this falls back
+ * to xdr_vector().
+ *
+ * \param[in]     xdrs         The XDR stream
+ * \param[in,out] data         The vector data
+ * \param[in]     numElements  The number of elements in \p data
+ * \param[in]     elemSize     The size of an element, should be 4 or 8
+ * \param[in]     elemProc     The XDR function for a single element
+ * \returns 1 on success, 0 on failure
+ */
+int xdr_vector_in_bulk(XDR *xdrs, char *data, int numElements,
+                       unsigned int elemSize, xdrproc_t elemProc);
+
 int xdr_xtc_seek_time(real time, FILE *fp, XDR *xdrs, int natoms, gmx_bool bSeekForwardOnly);
 
 
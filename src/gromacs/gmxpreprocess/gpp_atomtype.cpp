@@ -43,6 +43,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "gromacs/gmxpreprocess/grompp_impl.h"
 #include "gromacs/gmxpreprocess/notset.h"
@@ -85,10 +86,23 @@ class PreprocessingAtomTypes::Impl
     public:
         //! The number for currently loaded entries.
         size_t size() const { return types.size(); }
+        //! Rebuild the name lookup after types were changed.
+        void rebuildNameIndex();
         //! The actual atom type data.
         std::vector<AtomTypeData> types;
+        //! Index of the first atom type for each name.
+        std::unordered_map<std::string, int> nameIndex;
 };
 
+void PreprocessingAtomTypes::Impl::rebuildNameIndex()
+{
+    nameIndex.clear();
+    for (int i = 0; i < gmx::ssize(types); i++)
+    {
+        nameIndex.emplace(*types[i].name_, i);
+    }
+}
+
 bool PreprocessingAtomTypes::isSet(int nt) const
 {
     return ((nt >= 0) && (nt < gmx::ssize(*this)));
@@ -97,16 +111,14 @@ bool PreprocessingAtomTypes::isSet(int nt) const
 int PreprocessingAtomTypes::atomTypeFromName(const std::string &str) const
 {
     /* Atom types are always case sensitive */
-    auto found = std::find_if(impl_->types.begin(), impl_->types.end(),
-                              [&str](const auto &type)
-                              { return str == *type.name_; });
-    if (found == impl_->types.end())
+    auto found = impl_->nameIndex.find(str);
+    if (found == impl_->nameIndex.end())
     {
         return NOTSET;
     }
     else
     {
-        return std::distance(impl_->types.begin(), found);
+        return found->second;
     }
 }
 
@@ -191,6 +203,7 @@ int PreprocessingAtomTypes::addType(t_symtab                *tab,
                                   nb,
                                   bondAtomType,
                                   atomNumber);
+        impl_->nameIndex.emplace(name, impl_->types.size() - 1);
         return atomTypeFromName(name);
     }
     else
@@ -217,6 +230,7 @@ int PreprocessingAtomTypes::setType(int                      nt,
     impl_->types[nt].nb_           = nb;
     impl_->types[nt].bondAtomType_ = bondAtomType;
     impl_->types[nt].atomNumber_   = atomNumber;
+    impl_->rebuildNameIndex();
 
     return nt;
 }
@@ -376,6 +390,7 @@ void PreprocessingAtomTypes::renumberTypes(gmx::ArrayRef<InteractionsOfType>
     mtop->ffparams.atnr = nat;
 
     impl_->types                  = new_types;
+    impl_->rebuildNameIndex();
     plist[ftype].interactionTypes = nbsnew;
 }
 
@@ -101,6 +101,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/snprintf.h"
 
@@ -1669,20 +1670,25 @@ static void set_verlet_buffer(const gmx_mtop_t *mtop,
 
     printf("Determining Verlet buffer for a tolerance of %g kJ/mol/ps at %g K\n", ir->verletbuf_tol, buffer_temp);
 
+    /* grompp has no option for the number of threads, so we use
+     * the OpenMP default for the threaded drift estimate.
+     */
+    const int numThreads = gmx_omp_get_max_threads();
+
     /* Calculate the buffer size for simple atom vs atoms list */
     VerletbufListSetup listSetup1x1;
     listSetup1x1.cluster_size_i = 1;
     listSetup1x1.cluster_size_j = 1;
     const real rlist_1x1 =
         calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1,
-                             buffer_temp, listSetup1x1);
+                             buffer_temp, listSetup1x1, numThreads);
 
     /* Set the pair-list buffer size in ir */
     VerletbufListSetup listSetup4x4 =
         verletbufGetSafeListSetup(ListSetupType::CpuNoSimd);
     ir->rlist =
         calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1,
-                             buffer_temp, listSetup4x4);
+                             buffer_temp, listSetup4x4, numThreads);
 
     const int n_nonlin_vsite = countNonlinearVsites(*mtop);
     if (n_nonlin_vsite > 0)
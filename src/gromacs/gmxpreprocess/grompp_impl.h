@@ -39,6 +39,8 @@
 #define GMX_GMXPREPROCESS_GROMPP_IMPL_H
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/gmxpreprocess/notset.h"
 #include "gromacs/topology/atoms.h"
@@ -121,6 +123,23 @@ class InteractionOfType
         std::string                     interactionTypeName_;
 };
 
+/*! \libinternal \brief
+ * Hash function for a list of atom or atom type indices.
+ */
+struct AtomIndexListHash
+{
+    //! Returns the hash value for \p atoms.
+    size_t operator()(const std::vector<int> &atoms) const
+    {
+        size_t hash = atoms.size();
+        for (int atom : atoms)
+        {
+            hash = hash*1000003 ^ std::hash<int>()(atom);
+        }
+        return hash;
+    }
+};
+
 /*! \libinternal \brief
  * A set of interactions of a given type
  * (found in the enumeration in ifunc.h), complete with
@@ -142,6 +161,10 @@ struct InteractionsOfType
     std::vector<real>              cmap;
     //! The five atomtypes followed by a number that identifies the type.
     std::vector<int>               cmapAtomTypes;
+    //! Index of the first interaction type for each list of atom types, built on demand for default parameter lookup.
+    std::unordered_map<std::vector<int>, int, AtomIndexListHash> firstInteractionTypeIndex;
+    //! Number of interaction types that firstInteractionTypeIndex was built for.
+    size_t                         numIndexedInteractionTypes = 0;
 
     //! Number of parameters.
     size_t size() const { return interactionTypes.size(); }
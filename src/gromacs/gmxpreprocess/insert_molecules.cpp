@@ -74,6 +74,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 using gmx::RVec;
@@ -132,17 +133,28 @@ static void generate_trial_conf(gmx::ArrayRef<RVec> xin,
     }
 }
 
-static bool isInsertionAllowed(gmx::AnalysisNeighborhoodSearch *search,
-                               const std::vector<real>         &exclusionDistances,
-                               const std::vector<RVec>         &x,
-                               const std::vector<real>         &exclusionDistances_insrt,
-                               const t_atoms                   &atoms,
-                               const std::set<int>             &removableAtoms,
-                               gmx::AtomsRemover               *remover)
+/*! \brief
+ * Checks whether a molecule at positions \p x can be inserted.
+ *
+ * Atoms in \p removableAtoms that overlap with the molecule are added
+ * to \p overlappingAtoms, up to the first overlapping atom that is not
+ * removable, in which case false is returned. Their residues should be
+ * removed, also when the insertion is not allowed.
+ *
+ * This does not modify any shared state, so several insertions can be
+ * checked concurrently.
+ */
+static bool isInsertionAllowed(const gmx::AnalysisNeighborhoodSearch &search,
+                               const std::vector<real>               &exclusionDistances,
+                               const std::vector<RVec>               &x,
+                               const std::vector<real>               &exclusionDistances_insrt,
+                               const std::set<int>                   &removableAtoms,
+                               std::vector<int>                      *overlappingAtoms)
 {
     gmx::AnalysisNeighborhoodPositions  pos(x);
-    gmx::AnalysisNeighborhoodPairSearch pairSearch = search->startPairSearch(pos);
+    gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(pos);
     gmx::AnalysisNeighborhoodPair       pair;
+    overlappingAtoms->clear();
     while (pairSearch.findNextPair(&pair))
     {
         const real r1 = exclusionDistances[pair.refIndex()];
@@ -155,7 +167,7 @@ static bool isInsertionAllowed(gmx::AnalysisNeighborhoodSearch *search,
             }
             // TODO: If molecule information is available, this should ideally
             // use it to remove whole molecules.
-            remover->markResidue(atoms, pair.refIndex(), true);
+            overlappingAtoms->push_back(pair.refIndex());
         }
     }
     return true;
@@ -231,59 +243,109 @@ static void insert_mols(int nmol_insrt, int ntry, int seed,
         exclusionDistances.reserve(finalAtomCount);
     }
 
-    std::vector<RVec>                    x_n(x_insrt.size());
-
     int                                  mol        = 0;
     int                                  trial      = 0;
     int                                  firstTrial = 0;
     int                                  failed     = 0;
     gmx::UniformRealDistribution<real>   dist;
 
+    /* Several trial insertions are checked concurrently against the current
+     * system. The trials are generated in the same order from the random
+     * number stream and processed in that order, so the result does not
+     * depend on the number of threads. Trials after an accepted one are
+     * checked again against the updated system.
+     * With -ip, the trial position depends on the outcome of the previous
+     * trial, so only one trial is checked at a time.
+     */
+    const int                            maxBatchSize = insertAtPositions ? 1 : gmx_omp_get_max_threads();
+    std::vector<std::vector<RVec> >      trialX;
+    std::vector<char>                    trialAllowed;
+    std::vector<std::vector<int> >       trialOverlappingAtoms;
+
+    gmx::AnalysisNeighborhoodPositions   pos(*x);
+    gmx::AnalysisNeighborhoodSearch      search = nb.initSearch(&pbc, pos);
+
     while (mol < nmol_insrt && trial < ntry*nmol_insrt)
     {
-        rvec offset_x;
-        if (!insertAtPositions)
+        // Skip a position if ntry trials were not successful.
+        if (insertAtPositions && trial >= firstTrial + ntry)
         {
-            // Insert at random positions.
-            offset_x[XX] = box[XX][XX] * dist(rng);
-            offset_x[YY] = box[YY][YY] * dist(rng);
-            offset_x[ZZ] = box[ZZ][ZZ] * dist(rng);
+            fprintf(stderr, " skipped position (%.3f, %.3f, %.3f)\n",
+                    rpos[XX][mol], rpos[YY][mol], rpos[ZZ][mol]);
+            ++mol;
+            ++failed;
+            firstTrial = trial;
+            continue;
         }
-        else
+
+        const int batchSize = std::min(maxBatchSize, ntry*nmol_insrt - trial);
+        while (gmx::ssize(trialX) < batchSize)
         {
-            // Skip a position if ntry trials were not successful.
-            if (trial >= firstTrial + ntry)
+            rvec offset_x;
+            if (!insertAtPositions)
             {
-                fprintf(stderr, " skipped position (%.3f, %.3f, %.3f)\n",
-                        rpos[XX][mol], rpos[YY][mol], rpos[ZZ][mol]);
-                ++mol;
-                ++failed;
-                firstTrial = trial;
-                continue;
+                // Insert at random positions.
+                offset_x[XX] = box[XX][XX] * dist(rng);
+                offset_x[YY] = box[YY][YY] * dist(rng);
+                offset_x[ZZ] = box[ZZ][ZZ] * dist(rng);
             }
-            // Insert at positions taken from option -ip file.
-            offset_x[XX] = rpos[XX][mol] + deltaR[XX]*(2 * dist(rng)-1);
-            offset_x[YY] = rpos[YY][mol] + deltaR[YY]*(2 * dist(rng)-1);
-            offset_x[ZZ] = rpos[ZZ][mol] + deltaR[ZZ]*(2 * dist(rng)-1);
+            else
+            {
+                // Insert at positions taken from option -ip file.
+                offset_x[XX] = rpos[XX][mol] + deltaR[XX]*(2 * dist(rng)-1);
+                offset_x[YY] = rpos[YY][mol] + deltaR[YY]*(2 * dist(rng)-1);
+                offset_x[ZZ] = rpos[ZZ][mol] + deltaR[ZZ]*(2 * dist(rng)-1);
+            }
+            trialX.emplace_back();
+            generate_trial_conf(x_insrt, offset_x, enum_rot, &rng, &trialX.back());
         }
-        fprintf(stderr, "\rTry %d", ++trial);
-        fflush(stderr);
-
-        generate_trial_conf(x_insrt, offset_x, enum_rot, &rng, &x_n);
-        gmx::AnalysisNeighborhoodPositions pos(*x);
-        gmx::AnalysisNeighborhoodSearch    search = nb.initSearch(&pbc, pos);
-        if (isInsertionAllowed(&search, exclusionDistances, x_n, exclusionDistances_insrt,
-                               *atoms, removableAtoms, &remover))
+
+        const int numTrials = trialX.size();
+        trialAllowed.resize(numTrials);
+        trialOverlappingAtoms.resize(numTrials);
+        // The batch never holds more trials than there are threads
+#pragma omp parallel for num_threads(numTrials) schedule(dynamic)
+        for (int t = 0; t < numTrials; t++)
         {
-            x->insert(x->end(), x_n.begin(), x_n.end());
-            exclusionDistances.insert(exclusionDistances.end(),
-                                      exclusionDistances_insrt.begin(),
-                                      exclusionDistances_insrt.end());
-            builder.mergeAtoms(atoms_insrt);
-            ++mol;
-            firstTrial = trial;
-            fprintf(stderr, " success (now %d atoms)!\n", builder.currentAtomCount());
+            try
+            {
+                trialAllowed[t] = isInsertionAllowed(search, exclusionDistances, trialX[t],
+                                                     exclusionDistances_insrt, removableAtoms,
+                                                     &trialOverlappingAtoms[t]);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+
+        int numProcessed = 0;
+        while (numProcessed < numTrials)
+        {
+            const int t = numProcessed++;
+            fprintf(stderr, "\rTry %d", ++trial);
+            fflush(stderr);
+
+            for (int atomIndex : trialOverlappingAtoms[t])
+            {
+                remover.markResidue(*atoms, atomIndex, true);
+            }
+            if (trialAllowed[t])
+            {
+                x->insert(x->end(), trialX[t].begin(), trialX[t].end());
+                exclusionDistances.insert(exclusionDistances.end(),
+                                          exclusionDistances_insrt.begin(),
+                                          exclusionDistances_insrt.end());
+                builder.mergeAtoms(atoms_insrt);
+                ++mol;
+                firstTrial = trial;
+                fprintf(stderr, " success (now %d atoms)!\n", builder.currentAtomCount());
+
+                // Only rebuild the search after a successful insertion.
+                pos    = gmx::AnalysisNeighborhoodPositions(*x);
+                search.reset();
+                search = nb.initSearch(&pbc, pos);
+                break;
+            }
         }
+        trialX.erase(trialX.begin(), trialX.begin() + numProcessed);
     }
 
     fprintf(stderr, "\n");
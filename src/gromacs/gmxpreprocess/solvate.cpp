@@ -41,6 +41,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <numeric>
 #include <vector>
 
 #include "gromacs/commandline/pargs.h"
@@ -61,9 +62,11 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 using gmx::RVec;
@@ -394,6 +397,48 @@ static void replicateSolventBox(t_atoms *atoms, std::vector<RVec> *x,
             atoms->nr, atoms->nres);
 }
 
+/*! \brief
+ * Runs a pair search for test positions \p x in blocks, in parallel.
+ *
+ * \param[in] search      Search against the reference positions.
+ * \param[in] x           Test positions.
+ * \param[in] numBlocks   Number of contiguous blocks to divide \p x into.
+ * \param[in] handlePair  Called as handlePair(block, pair, testIndex, &pairSearch)
+ *     for every pair found, with testIndex the index in \p x.
+ *
+ * The blocks are searched concurrently, so \p handlePair should only
+ * modify data belonging to its block or test position. Within a block,
+ * pairs are passed in the same order as a serial search returns them.
+ */
+template <typename PairHandler>
+static void searchPairsInBlocks(const gmx::AnalysisNeighborhoodSearch &search,
+                                const std::vector<RVec>               &x,
+                                int                                    numBlocks,
+                                PairHandler                            handlePair)
+{
+    const int numPositions = x.size();
+#pragma omp parallel for num_threads(numBlocks) schedule(static, 1)
+    for (int block = 0; block < numBlocks; block++)
+    {
+        try
+        {
+            const int        begin = (numPositions*block)/numBlocks;
+            const int        end   = (numPositions*(block + 1))/numBlocks;
+            std::vector<int> indices(end - begin);
+            std::iota(indices.begin(), indices.end(), begin);
+            gmx::AnalysisNeighborhoodPositions  pos(x);
+            pos.indexed(indices);
+            gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(pos);
+            gmx::AnalysisNeighborhoodPair       pair;
+            while (pairSearch.findNextPair(&pair))
+            {
+                handlePair(block, pair, indices[pair.testIndex()], &pairSearch);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
 /*! \brief
  * Removes overlap of solvent atoms across the edges.
  *
@@ -427,53 +472,72 @@ static void removeSolventBoxOverlap(t_atoms *atoms, std::vector<RVec> *x,
     nb.setCutoff(2*maxRadius);
     gmx::AnalysisNeighborhoodPositions  pos(*x);
     gmx::AnalysisNeighborhoodSearch     search     = nb.initSearch(&pbc, pos);
-    gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(pos);
-    gmx::AnalysisNeighborhoodPair       pair;
-    while (pairSearch.findNextPair(&pair))
+
+    // Pairs of overlapping atoms in different residues where at least one
+    // of the atoms is a candidate for removal.
+    struct OverlapPair
     {
-        const int  i1 = pair.refIndex();
-        const int  i2 = pair.testIndex();
-        if (remover.isMarked(i2))
-        {
-            pairSearch.skipRemainingPairsForTestPosition();
-            continue;
-        }
-        if (remover.isMarked(i1) || atoms->atom[i1].resind == atoms->atom[i2].resind)
-        {
-            continue;
-        }
-        if (pair.distance2() < gmx::square((*r)[i1] + (*r)[i2]))
+        int  i1, i2;
+        bool bCandidate1, bCandidate2;
+    };
+    // Which of these pairs lead to removal depends on the order in which
+    // they are processed, so we find them in parallel and then process
+    // them serially in the order a serial search would find them.
+    const int                              numBlocks = gmx_omp_get_max_threads();
+    std::vector<std::vector<OverlapPair> > blockPairs(numBlocks);
+    // To satisfy Clang static analyzer.
+    GMX_ASSERT(pbc.ndim_ePBC <= DIM, "Too many periodic dimensions");
+    searchPairsInBlocks(search, *x, numBlocks,
+                        [&](int block, const gmx::AnalysisNeighborhoodPair &pair, int i2,
+                            gmx::AnalysisNeighborhoodPairSearch *)
+                        {
+                            const int i1 = pair.refIndex();
+                            if (atoms->atom[i1].resind == atoms->atom[i2].resind ||
+                                pair.distance2() >= gmx::square((*r)[i1] + (*r)[i2]))
+                            {
+                                return;
+                            }
+                            rvec dx;
+                            rvec_sub((*x)[i2], (*x)[i1], dx);
+                            bool bCandidate1 = false, bCandidate2 = false;
+                            for (int d = 0; d < pbc.ndim_ePBC; ++d)
+                            {
+                                // If the distance in some dimension is larger than the
+                                // cutoff, then it means that the distance has been computed
+                                // over the PBC.  Mark the position with a larger coordinate
+                                // for potential removal.
+                                if (dx[d] > maxRadius)
+                                {
+                                    bCandidate2 = true;
+                                }
+                                else if (dx[d] < -maxRadius)
+                                {
+                                    bCandidate1 = true;
+                                }
+                            }
+                            if (bCandidate1 || bCandidate2)
+                            {
+                                blockPairs[block].push_back({ i1, i2, bCandidate1, bCandidate2 });
+                            }
+                        });
+
+    for (const auto &pairs : blockPairs)
+    {
+        for (const OverlapPair &pair : pairs)
         {
-            rvec dx;
-            rvec_sub((*x)[i2], (*x)[i1], dx);
-            bool bCandidate1 = false, bCandidate2 = false;
-            // To satisfy Clang static analyzer.
-            GMX_ASSERT(pbc.ndim_ePBC <= DIM, "Too many periodic dimensions");
-            for (int d = 0; d < pbc.ndim_ePBC; ++d)
+            if (remover.isMarked(pair.i2) || remover.isMarked(pair.i1))
             {
-                // If the distance in some dimension is larger than the
-                // cutoff, then it means that the distance has been computed
-                // over the PBC.  Mark the position with a larger coordinate
-                // for potential removal.
-                if (dx[d] > maxRadius)
-                {
-                    bCandidate2 = true;
-                }
-                else if (dx[d] < -maxRadius)
-                {
-                    bCandidate1 = true;
-                }
+                continue;
             }
             // Only mark one of the positions for removal if both were
             // candidates.
-            if (bCandidate2 && (!bCandidate1 || i2 > i1))
+            if (pair.bCandidate2 && (!pair.bCandidate1 || pair.i2 > pair.i1))
             {
-                remover.markResidue(*atoms, i2, true);
-                pairSearch.skipRemainingPairsForTestPosition();
+                remover.markResidue(*atoms, pair.i2, true);
             }
-            else if (bCandidate1)
+            else if (pair.bCandidate1)
             {
-                remover.markResidue(*atoms, i1, true);
+                remover.markResidue(*atoms, pair.i1, true);
             }
         }
     }
@@ -565,23 +629,31 @@ static void removeSolventOverlappingWithSolute(t_atoms                 *atoms,
 
     // Now check for overlap.
     gmx::AnalysisNeighborhood           nb;
-    gmx::AnalysisNeighborhoodPair       pair;
     nb.setCutoff(maxRadius1 + maxRadius2);
     gmx::AnalysisNeighborhoodPositions  posSolute(x_solute);
     gmx::AnalysisNeighborhoodSearch     search     = nb.initSearch(&pbc, posSolute);
-    gmx::AnalysisNeighborhoodPositions  pos(*x);
-    gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(pos);
-    while (pairSearch.findNextPair(&pair))
+    // Find the overlapping solvent atoms in parallel, each thread
+    // only writes to the elements for its own test positions.
+    std::vector<char>                   overlaps(x->size(), 0);
+    searchPairsInBlocks(search, *x, gmx_omp_get_max_threads(),
+                        [&](int, const gmx::AnalysisNeighborhoodPair &pair, int testIndex,
+                            gmx::AnalysisNeighborhoodPairSearch *pairSearch)
+                        {
+                            const real r1 = r_solute[pair.refIndex()];
+                            const real r2 = (*r)[testIndex];
+                            if (pair.distance2() < gmx::square(r1 + r2))
+                            {
+                                overlaps[testIndex] = 1;
+                                pairSearch->skipRemainingPairsForTestPosition();
+                            }
+                        });
+    // Remove whole residues with at least one overlapping atom
+    for (int i = 0; i < gmx::ssize(overlaps); i++)
     {
-        if (remover.isMarked(pair.testIndex()))
+        if (overlaps[i] && !remover.isMarked(i))
         {
-            pairSearch.skipRemainingPairsForTestPosition();
-            continue;
+            remover.markResidue(*atoms, i, true);
         }
-        const real r1      = r_solute[pair.refIndex()];
-        const real r2      = (*r)[pair.testIndex()];
-        const bool bRemove = (pair.distance2() < gmx::square(r1 + r2));
-        remover.markResidue(*atoms, pair.testIndex(), bRemove);
     }
 
     remover.removeMarkedElements(x);
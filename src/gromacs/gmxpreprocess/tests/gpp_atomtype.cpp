@@ -140,6 +140,16 @@ TEST_F(PreprocessingAtomTypesTest, WrongNameNotFound)
     EXPECT_EQ(atypes_.atomTypeFromName("Bar"), NOTSET);
 }
 
+TEST_F(PreprocessingAtomTypesTest, NameFoundAfterSetType)
+{
+    EXPECT_EQ(addType("Foo", 1, 2), 0);
+    EXPECT_EQ(addType("Bar", 3, 4), 1);
+    EXPECT_EQ(atypes_.setType(0, &symtab_, atom_, "Baz", nb_, 1, 2), 0);
+    EXPECT_EQ(atypes_.atomTypeFromName("Foo"), NOTSET);
+    EXPECT_EQ(atypes_.atomTypeFromName("Baz"), 0);
+    EXPECT_EQ(atypes_.atomTypeFromName("Bar"), 1);
+}
+
 TEST_F(PreprocessingAtomTypesTest, CorrectNameFromTypeNumber)
 {
     EXPECT_EQ(addType("Foo", 1, 2), 0);
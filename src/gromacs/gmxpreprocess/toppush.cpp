@@ -1666,88 +1666,44 @@ static bool default_cmap_params(gmx::ArrayRef<InteractionsOfType> bondtype,
     return bFound;
 }
 
-/* Returns the number of exact atom type matches, i.e. non wild-card matches,
- * returns -1 when there are no matches at all.
+/*! \brief Returns the index of the first interaction type in \p bt with
+ * exactly the atom types \p types, or -1 when there is none.
+ *
+ * Uses a hashed index that is (re)built when interaction types have been
+ * added since the last lookup.
  */
-static int natom_match(const InteractionOfType &pi,
-                       int type_i, int type_j, int type_k, int type_l,
-                       const PreprocessingAtomTypes* atypes)
-{
-    if ((pi.ai() == -1 || atypes->bondAtomTypeFromAtomType(type_i) == pi.ai()) &&
-        (pi.aj() == -1 || atypes->bondAtomTypeFromAtomType(type_j) == pi.aj()) &&
-        (pi.ak() == -1 || atypes->bondAtomTypeFromAtomType(type_k) == pi.ak()) &&
-        (pi.al() == -1 || atypes->bondAtomTypeFromAtomType(type_l) == pi.al()))
-    {
-        return
-            (pi.ai() == -1 ? 0 : 1) +
-            (pi.aj() == -1 ? 0 : 1) +
-            (pi.ak() == -1 ? 0 : 1) +
-            (pi.al() == -1 ? 0 : 1);
-    }
-    else
-    {
-        return -1;
-    }
-}
-
-static int findNumberOfDihedralAtomMatches(const InteractionOfType            &currentParamFromParameterArray,
-                                           const InteractionOfType            &parameterToAdd,
-                                           const t_atoms                      *at,
-                                           const PreprocessingAtomTypes       *atypes,
-                                           bool                                bB)
-{
-    if (bB)
-    {
-        return natom_match(currentParamFromParameterArray,
-                           at->atom[parameterToAdd.ai()].typeB,
-                           at->atom[parameterToAdd.aj()].typeB,
-                           at->atom[parameterToAdd.ak()].typeB,
-                           at->atom[parameterToAdd.al()].typeB, atypes);
-    }
-    else
-    {
-        return natom_match(currentParamFromParameterArray,
-                           at->atom[parameterToAdd.ai()].type,
-                           at->atom[parameterToAdd.aj()].type,
-                           at->atom[parameterToAdd.ak()].type,
-                           at->atom[parameterToAdd.al()].type, atypes);
-    }
-}
-
-static bool findIfAllParameterAtomsMatch(gmx::ArrayRef<const int>      atomsFromParameterArray,
-                                         gmx::ArrayRef<const int>      atomsFromCurrentParameter,
-                                         const t_atoms                *at,
-                                         const PreprocessingAtomTypes *atypes,
-                                         bool                          bB)
+static int findFirstInteractionTypeIndex(InteractionsOfType     *bt,
+                                         const std::vector<int> &types)
 {
-    if (atomsFromParameterArray.size() != atomsFromCurrentParameter.size())
-    {
-        return false;
-    }
-    else if (bB)
-    {
-        for (int i = 0; i < atomsFromCurrentParameter.ssize(); i++)
+    const auto buildIndex = [bt]()
         {
-            if (atypes->bondAtomTypeFromAtomType(
-                        at->atom[atomsFromCurrentParameter[i]].typeB) != atomsFromParameterArray[i])
+            bt->firstInteractionTypeIndex.clear();
+            for (int i = 0; i < gmx::ssize(bt->interactionTypes); i++)
             {
-                return false;
+                gmx::ArrayRef<const int> atoms = bt->interactionTypes[i].atoms();
+                /* emplace does not overwrite, so we keep the first match */
+                bt->firstInteractionTypeIndex.emplace(std::vector<int>(atoms.begin(), atoms.end()), i);
             }
-        }
-        return true;
+            bt->numIndexedInteractionTypes = bt->interactionTypes.size();
+        };
+
+    if (bt->numIndexedInteractionTypes != bt->interactionTypes.size())
+    {
+        buildIndex();
     }
-    else
+    auto found = bt->firstInteractionTypeIndex.find(types);
+    if (found != bt->firstInteractionTypeIndex.end())
     {
-        for (int i = 0; i < atomsFromCurrentParameter.ssize(); i++)
+        gmx::ArrayRef<const int> atoms = bt->interactionTypes[found->second].atoms();
+        if (!std::equal(atoms.begin(), atoms.end(), types.begin(), types.end()))
         {
-            if (atypes->bondAtomTypeFromAtomType(
-                        at->atom[atomsFromCurrentParameter[i]].type) != atomsFromParameterArray[i])
-            {
-                return false;
-            }
+            /* The list was modified without changing its size */
+            buildIndex();
+            found = bt->firstInteractionTypeIndex.find(types);
         }
-        return true;
     }
+
+    return (found != bt->firstInteractionTypeIndex.end()) ? found->second : -1;
 }
 
 static std::vector<InteractionOfType>::iterator
@@ -1765,29 +1721,55 @@ defaultInteractionsOfType(int ftype, gmx::ArrayRef<InteractionsOfType> bt,
         return bt[ftype].interactionTypes.end();
     }
 
+    /* The bonded atom types of the atoms in this interaction */
+    std::vector<int> types;
+    for (int atom : p.atoms())
+    {
+        types.push_back(atypes->bondAtomTypeFromAtomType(bB ? at->atom[atom].typeB : at->atom[atom].type));
+    }
 
     nparam_found = 0;
     if (ftype == F_PDIHS || ftype == F_RBDIHS || ftype == F_IDIHS || ftype == F_PIDIHS)
     {
         int nmatch_max = -1;
+        int bestIndex  = -1;
 
         /* For dihedrals we allow wildcards. We choose the first type
          * that has the most real matches, i.e. non-wildcard matches.
+         * We look up all combinations of our types and wildcards (-1).
          */
-        auto prevPos = bt[ftype].interactionTypes.end();
-        auto pos     = bt[ftype].interactionTypes.begin();
-        while (pos != bt[ftype].interactionTypes.end() && nmatch_max < 4)
+        const int        numAtoms = types.size();
+        std::vector<int> pattern(numAtoms);
+        for (int mask = 0; mask < (1 << numAtoms); mask++)
         {
-            pos = std::find_if(bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                               [&p, &at, &atypes, &bB, &nmatch_max](const auto &param)
-                               { return (findNumberOfDihedralAtomMatches(param, p, at, atypes, bB) > nmatch_max); });
-            if (pos != bt[ftype].interactionTypes.end())
+            int nmatch = 0;
+            for (int k = 0; k < numAtoms; k++)
+            {
+                if (mask & (1 << k))
+                {
+                    pattern[k] = types[k];
+                    nmatch++;
+                }
+                else
+                {
+                    pattern[k] = -1;
+                }
+            }
+            int index = findFirstInteractionTypeIndex(&bt[ftype], pattern);
+            if (index >= 0 &&
+                (nmatch > nmatch_max || (nmatch == nmatch_max && index < bestIndex)))
             {
-                prevPos    = pos;
-                nmatch_max = findNumberOfDihedralAtomMatches(*pos, p, at, atypes, bB);
+                nmatch_max = nmatch;
+                bestIndex  = index;
             }
         }
 
+        auto prevPos = bt[ftype].interactionTypes.end();
+        if (bestIndex >= 0)
+        {
+            prevPos = bt[ftype].interactionTypes.begin() + bestIndex;
+        }
+
         if (prevPos != bt[ftype].interactionTypes.end())
         {
             nparam_found++;
@@ -1821,13 +1803,11 @@ defaultInteractionsOfType(int ftype, gmx::ArrayRef<InteractionsOfType> bt,
     }
     else   /* Not a dihedral */
     {
-        gmx::ArrayRef<const int> atomParam = p.atoms();
-        auto                     found     = std::find_if(bt[ftype].interactionTypes.begin(),
-                                                          bt[ftype].interactionTypes.end(),
-                                                          [&atomParam, &at, &atypes, &bB](const auto &param)
-                                                          { return findIfAllParameterAtomsMatch(param.atoms(), atomParam, at, atypes, bB); });
-        if (found != bt[ftype].interactionTypes.end())
+        int  index = findFirstInteractionTypeIndex(&bt[ftype], types);
+        auto found = bt[ftype].interactionTypes.end();
+        if (index >= 0)
         {
+            found        = bt[ftype].interactionTypes.begin() + index;
             nparam_found = 1;
         }
         *nparam_def = nparam_found;
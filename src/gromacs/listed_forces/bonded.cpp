@@ -69,6 +69,7 @@
 #include "gromacs/simd/vector_operations.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -3267,7 +3268,7 @@ cmap_dihs(int nbonds,
         rvec_inc(fshift[t21], f1_k);
         rvec_inc(fshift[t31], f1_l);
 
-        rvec_inc(fshift[t21], f2_i);
+        rvec_inc(fshift[t12], f2_i);
         rvec_inc(fshift[CENTRAL], f2_j);
         rvec_inc(fshift[t22], f2_k);
         rvec_inc(fshift[t32], f2_l);
@@ -3276,6 +3277,328 @@ cmap_dihs(int nbonds,
 }
 
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief Adds the shift forces of GMX_SIMD_REAL_WIDTH dihedrals
+ *
+ * The forces are passed as for do_dih_fup_noshiftf_simd(). Only the first
+ * \p numDihedrals lanes are used. Note that without PBC all shifts are
+ * central and the contributions cancel, so this should then not be called.
+ */
+static void
+addDihedralShiftForcesSimd(int numDihedrals,
+                           const int *ai, const int *aj, const int *ak, const int *al,
+                           SimdReal p, SimdReal q,
+                           SimdReal f_i_x,  SimdReal f_i_y,  SimdReal f_i_z,
+                           SimdReal mf_l_x, SimdReal mf_l_y, SimdReal mf_l_z,
+                           const rvec x[], const t_pbc *pbc, rvec fshift[])
+{
+    alignas(GMX_SIMD_ALIGNMENT) real buf[9*GMX_SIMD_REAL_WIDTH];
+
+    SimdReal                         sx = p * f_i_x + q * mf_l_x;
+    SimdReal                         sy = p * f_i_y + q * mf_l_y;
+    SimdReal                         sz = p * f_i_z + q * mf_l_z;
+
+    /* Store the forces on atoms i, k and l, the force on j is minus their sum */
+    store(buf + 0*GMX_SIMD_REAL_WIDTH, f_i_x);
+    store(buf + 1*GMX_SIMD_REAL_WIDTH, f_i_y);
+    store(buf + 2*GMX_SIMD_REAL_WIDTH, f_i_z);
+    store(buf + 3*GMX_SIMD_REAL_WIDTH, mf_l_x - sx);
+    store(buf + 4*GMX_SIMD_REAL_WIDTH, mf_l_y - sy);
+    store(buf + 5*GMX_SIMD_REAL_WIDTH, mf_l_z - sz);
+    store(buf + 6*GMX_SIMD_REAL_WIDTH, -mf_l_x);
+    store(buf + 7*GMX_SIMD_REAL_WIDTH, -mf_l_y);
+    store(buf + 8*GMX_SIMD_REAL_WIDTH, -mf_l_z);
+
+    for (int s = 0; s < numDihedrals; s++)
+    {
+        rvec dx;
+        int  shift[3];
+        shift[0] = pbc_dx_aiuc(pbc, x[ai[s]], x[aj[s]], dx);
+        shift[1] = pbc_dx_aiuc(pbc, x[ak[s]], x[aj[s]], dx);
+        shift[2] = pbc_dx_aiuc(pbc, x[al[s]], x[aj[s]], dx);
+        for (int a = 0; a < 3; a++)
+        {
+            for (int m = 0; m < DIM; m++)
+            {
+                real force = buf[(a*DIM + m)*GMX_SIMD_REAL_WIDTH + s];
+                fshift[shift[a]][m] += force;
+                fshift[CENTRAL][m]  -= force;
+            }
+        }
+    }
+}
+
+/*! \brief As cmap_dihs(), but using SIMD to calculate many CMAP terms at once
+ *
+ * The dihedral angles and the bicubic interpolation are computed with SIMD,
+ * the grid patches are gathered per term into transposed buffers.
+ * When \p computeEnergy is true, the energy is returned and the shift
+ * forces are computed, otherwise only the forces are computed.
+ * The graph is not supported.
+ */
+template<bool computeEnergy>
+static real
+cmapDihsSimd(int nbonds,
+             const t_iatom forceatoms[], const t_iparams forceparams[],
+             const gmx_cmap_t *cmap_grid,
+             const rvec x[], rvec4 f[], rvec fshift[],
+             const t_pbc *pbc)
+{
+    const int                                nfa1        = 6;
+    const int                                gridSpacing = cmap_grid->grid_spacing;
+    /* The grid spacing in radians and degrees */
+    const real                               dxRad       = 2*M_PI/gridSpacing;
+    const real                               dxDeg       = 360.0/gridSpacing;
+
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t am[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         scale[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         xphi1[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         xphi2[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         gridIndex1[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         gridIndex2[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tx[16*GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+    int                                      cmapIndex[GMX_SIMD_REAL_WIDTH];
+
+    /* Scaling of V, dV/dphi1, dV/dphi2 and d2V/dphi1dphi2 to grid units */
+    const real                               txScale[4]  = { 1, dxDeg, dxDeg, dxDeg*dxDeg };
+
+    const SimdReal                           pi_S(M_PI);
+    const SimdReal                           twoPi_S(2*M_PI);
+    const SimdReal                           zero_S(0.0);
+    const SimdReal                           two_S(2.0);
+    const SimdReal                           three_S(3.0);
+    const SimdReal                           rad2deg_S(RAD2DEG);
+    const SimdReal                           dxDeg_S(dxDeg);
+    const SimdReal                           invDxDeg_S(1/dxDeg);
+    const SimdReal                           forceScale_S(RAD2DEG/dxDeg);
+
+    SimdReal                                 vtot_S = setZero();
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of CMAP terms times nfa1, here we step GMX_SIMD_REAL_WIDTH terms */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH*nfa1)
+    {
+        const int numTerms = std::min(GMX_SIMD_REAL_WIDTH, (nbonds - i)/nfa1);
+
+        /* Collect the five atoms of GMX_SIMD_REAL_WIDTH CMAP terms.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            int type     = forceatoms[iu];
+            ai[s]        = forceatoms[iu + 1];
+            aj[s]        = forceatoms[iu + 2];
+            ak[s]        = forceatoms[iu + 3];
+            al[s]        = forceatoms[iu + 4];
+            am[s]        = forceatoms[iu + 5];
+            cmapIndex[s] = forceparams[type].cmap.cmapA;
+
+            /* At the end fill the arrays with the last term and zero scaling */
+            if (s < numTerms)
+            {
+                scale[s] = 1;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                scale[s] = 0;
+            }
+        }
+
+        SimdReal phi1_S, mx1_S, my1_S, mz1_S, nx1_S, ny1_S, nz1_S;
+        SimdReal nrkj_m21_S, nrkj_n21_S, p1_S, q1_S;
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd,
+                       &phi1_S,
+                       &mx1_S, &my1_S, &mz1_S,
+                       &nx1_S, &ny1_S, &nz1_S,
+                       &nrkj_m21_S,
+                       &nrkj_n21_S,
+                       &p1_S, &q1_S);
+
+        SimdReal phi2_S, mx2_S, my2_S, mz2_S, nx2_S, ny2_S, nz2_S;
+        SimdReal nrkj_m22_S, nrkj_n22_S, p2_S, q2_S;
+        dih_angle_simd(x, aj, ak, al, am, pbc_simd,
+                       &phi2_S,
+                       &mx2_S, &my2_S, &mz2_S,
+                       &nx2_S, &ny2_S, &nz2_S,
+                       &nrkj_m22_S,
+                       &nrkj_n22_S,
+                       &p2_S, &q2_S);
+
+        /* Shift the angles to the grid range [0, 2 pi) */
+        SimdReal xphi1_S = phi1_S + pi_S;
+        SimdReal xphi2_S = phi2_S + pi_S;
+        xphi1_S          = xphi1_S + selectByMask(twoPi_S, xphi1_S < zero_S);
+        xphi1_S          = xphi1_S - selectByMask(twoPi_S, twoPi_S <= xphi1_S);
+        xphi2_S          = xphi2_S + selectByMask(twoPi_S, xphi2_S < zero_S);
+        xphi2_S          = xphi2_S - selectByMask(twoPi_S, twoPi_S <= xphi2_S);
+        store(xphi1, xphi1_S);
+        store(xphi2, xphi2_S);
+
+        /* Gather the grid patches, transposed such that we can load
+         * one of the 16 values for all terms at once.
+         */
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const real *cmapd = cmap_grid->cmapdata[cmapIndex[s]].cmap.data();
+
+            int         ip1m1, ip1p1, ip1p2;
+            int         ip2m1, ip2p1, ip2p2;
+            int         iphi1 = cmap_setup_grid_index(static_cast<int>(xphi1[s]/dxRad), gridSpacing,
+                                                      &ip1m1, &ip1p1, &ip1p2);
+            int         iphi2 = cmap_setup_grid_index(static_cast<int>(xphi2[s]/dxRad), gridSpacing,
+                                                      &ip2m1, &ip2p1, &ip2p2);
+            gridIndex1[s] = iphi1;
+            gridIndex2[s] = iphi2;
+
+            const int   pos[4] = {
+                iphi1*gridSpacing + iphi2,
+                ip1p1*gridSpacing + iphi2,
+                ip1p1*gridSpacing + ip2p1,
+                iphi1*gridSpacing + ip2p1
+            };
+            for (int v = 0; v < 4; v++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    tx[(v*4 + c)*GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c]*4 + v]*txScale[v];
+                }
+            }
+        }
+
+        /* Compute the bicubic interpolation coefficients */
+        SimdReal tx_S[16];
+        for (int k = 0; k < 16; k++)
+        {
+            tx_S[k] = load<SimdReal>(tx + k*GMX_SIMD_REAL_WIDTH);
+        }
+        SimdReal tc_S[16];
+        for (int idx = 0; idx < 16; idx++)
+        {
+            tc_S[idx] = setZero();
+            for (int k = 0; k < 16; k++)
+            {
+                if (cmap_coeff_matrix[k*16 + idx] != 0)
+                {
+                    tc_S[idx] = fma(SimdReal(cmap_coeff_matrix[k*16 + idx]), tx_S[k], tc_S[idx]);
+                }
+            }
+        }
+
+        SimdReal tt_S = fnma(load<SimdReal>(gridIndex1), dxDeg_S, xphi1_S*rad2deg_S)*invDxDeg_S;
+        SimdReal tu_S = fnma(load<SimdReal>(gridIndex2), dxDeg_S, xphi2_S*rad2deg_S)*invDxDeg_S;
+
+        SimdReal e_S   = setZero();
+        SimdReal df1_S = setZero();
+        SimdReal df2_S = setZero();
+        for (int j = 3; j >= 0; j--)
+        {
+            e_S   = fma(tt_S, e_S, fma(fma(fma(tc_S[j*4 + 3], tu_S, tc_S[j*4 + 2]), tu_S, tc_S[j*4 + 1]), tu_S, tc_S[j*4]));
+            df1_S = fma(tu_S, df1_S, fma(fma(three_S*tc_S[12 + j], tt_S, two_S*tc_S[8 + j]), tt_S, tc_S[4 + j]));
+            df2_S = fma(tt_S, df2_S, fma(fma(three_S*tc_S[j*4 + 3], tu_S, two_S*tc_S[j*4 + 2]), tu_S, tc_S[j*4 + 1]));
+        }
+
+        SimdReal scale_S = load<SimdReal>(scale);
+        df1_S            = df1_S * forceScale_S * scale_S;
+        df2_S            = df2_S * forceScale_S * scale_S;
+
+        if (computeEnergy)
+        {
+            vtot_S = fma(e_S, scale_S, vtot_S);
+        }
+
+        /* After this m?_S will contain f[i] and n?_S -f[l] */
+        SimdReal sf_i1_S  = -df1_S * nrkj_m21_S;
+        SimdReal msf_l1_S = -df1_S * nrkj_n21_S;
+        mx1_S             = sf_i1_S * mx1_S;
+        my1_S             = sf_i1_S * my1_S;
+        mz1_S             = sf_i1_S * mz1_S;
+        nx1_S             = msf_l1_S * nx1_S;
+        ny1_S             = msf_l1_S * ny1_S;
+        nz1_S             = msf_l1_S * nz1_S;
+
+        SimdReal sf_i2_S  = -df2_S * nrkj_m22_S;
+        SimdReal msf_l2_S = -df2_S * nrkj_n22_S;
+        mx2_S             = sf_i2_S * mx2_S;
+        my2_S             = sf_i2_S * my2_S;
+        mz2_S             = sf_i2_S * mz2_S;
+        nx2_S             = msf_l2_S * nx2_S;
+        ny2_S             = msf_l2_S * ny2_S;
+        nz2_S             = msf_l2_S * nz2_S;
+
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al,
+                                 p1_S, q1_S,
+                                 mx1_S, my1_S, mz1_S,
+                                 nx1_S, ny1_S, nz1_S,
+                                 f);
+        do_dih_fup_noshiftf_simd(aj, ak, al, am,
+                                 p2_S, q2_S,
+                                 mx2_S, my2_S, mz2_S,
+                                 nx2_S, ny2_S, nz2_S,
+                                 f);
+
+        if (computeEnergy && pbc != nullptr)
+        {
+            addDihedralShiftForcesSimd(numTerms, ai, aj, ak, al,
+                                       p1_S, q1_S,
+                                       mx1_S, my1_S, mz1_S,
+                                       nx1_S, ny1_S, nz1_S,
+                                       x, pbc, fshift);
+            addDihedralShiftForcesSimd(numTerms, aj, ak, al, am,
+                                       p2_S, q2_S,
+                                       mx2_S, my2_S, mz2_S,
+                                       nx2_S, ny2_S, nz2_S,
+                                       x, pbc, fshift);
+        }
+    }
+
+    return computeEnergy ? reduce(vtot_S) : 0;
+}
+
+real
+cmap_dihs_simd(int nbonds,
+               const t_iatom forceatoms[], const t_iparams forceparams[],
+               const gmx_cmap_t *cmap_grid,
+               const rvec x[], rvec4 f[], rvec fshift[],
+               const struct t_pbc *pbc, const struct t_graph gmx_unused *g,
+               real gmx_unused lambda, real gmx_unused *dvdlambda,
+               const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+               int gmx_unused *global_atom_index)
+{
+    GMX_ASSERT(g == nullptr, "The SIMD CMAP kernel does not support shift forces with a graph");
+
+    return cmapDihsSimd<true>(nbonds, forceatoms, forceparams, cmap_grid,
+                              x, f, fshift, pbc);
+}
+
+void
+cmap_dihs_noener_simd(int nbonds,
+                      const t_iatom forceatoms[], const t_iparams forceparams[],
+                      const gmx_cmap_t *cmap_grid,
+                      const rvec x[], rvec4 f[],
+                      const struct t_pbc *pbc, const struct t_graph gmx_unused *g,
+                      real gmx_unused lambda,
+                      const t_mdatoms gmx_unused *md, t_fcdata gmx_unused *fcd,
+                      int gmx_unused *global_atom_index)
+{
+    cmapDihsSimd<false>(nbonds, forceatoms, forceparams, cmap_grid,
+                        x, f, nullptr, pbc);
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 //! \cond
 /***********************************************************
  *
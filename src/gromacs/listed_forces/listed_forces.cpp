@@ -73,6 +73,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 
 #include "listed_internal.h"
@@ -294,13 +295,41 @@ reduce_thread_forces(int n, rvec *f,
                 int a1 = (ind + 1)*reduction_block_size;
                 /* It would be nice if we could pad f to avoid this min */
                 a1     = std::min(a1, n);
-                for (int a = a0; a < a1; a++)
+
+                /* First sum the contributions over the whole block, the thread
+                 * buffers are aligned and zeroed for complete blocks. This
+                 * loop is over contiguous rvec4 data and vectorizes well.
+                 */
+                alignas(GMX_SIMD_ALIGNMENT) real fBlock[reduction_block_size*4];
+                const int                        offset = a0*4;
+#if GMX_SIMD_HAVE_REAL
+                for (int i = 0; i < reduction_block_size*4; i += GMX_SIMD_REAL_WIDTH)
+                {
+                    gmx::SimdReal fSum = gmx::load<gmx::SimdReal>(fp[0][0] + offset + i);
+                    for (int fb = 1; fb < nfb; fb++)
+                    {
+                        fSum = fSum + gmx::load<gmx::SimdReal>(fp[fb][0] + offset + i);
+                    }
+                    store(fBlock + i, fSum);
+                }
+#else
+                for (int i = 0; i < reduction_block_size*4; i++)
                 {
-                    for (int fb = 0; fb < nfb; fb++)
+                    fBlock[i] = fp[0][0][offset + i];
+                }
+                for (int fb = 1; fb < nfb; fb++)
+                {
+                    for (int i = 0; i < reduction_block_size*4; i++)
                     {
-                        rvec_inc(f[a], fp[fb][a]);
+                        fBlock[i] += fp[fb][0][offset + i];
                     }
                 }
+#endif
+                /* Add the sum to the, differently strided, force buffer */
+                for (int a = a0; a < a1; a++)
+                {
+                    rvec_inc(f[a], fBlock + (a - a0)*4);
+                }
             }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
@@ -422,11 +451,34 @@ calc_one_bond(int thread,
                nice to account to its own subtimer, but first
                wallcycle needs to be extended to support calling from
                multiple threads. */
-            v = cmap_dihs(nbn, iatoms+nb0,
-                          idef->iparams, idef->cmap_grid,
-                          x, f, fshift,
-                          pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
-                          md, fcd, global_atom_index);
+#if GMX_SIMD_HAVE_REAL
+            if (bUseSIMD && computeForcesOnly)
+            {
+                /* No energies, shift forces, dvdl */
+                cmap_dihs_noener_simd(nbn, iatoms+nb0,
+                                      idef->iparams, idef->cmap_grid,
+                                      x, f,
+                                      pbc, g, lambda[efptFTYPE], md, fcd,
+                                      global_atom_index);
+                v = 0;
+            }
+            else if (bUseSIMD && g == nullptr)
+            {
+                v = cmap_dihs_simd(nbn, iatoms+nb0,
+                                   idef->iparams, idef->cmap_grid,
+                                   x, f, fshift,
+                                   pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                                   md, fcd, global_atom_index);
+            }
+            else
+#endif
+            {
+                v = cmap_dihs(nbn, iatoms+nb0,
+                              idef->iparams, idef->cmap_grid,
+                              x, f, fshift,
+                              pbc, g, lambda[efptFTYPE], &(dvdl[efptFTYPE]),
+                              md, fcd, global_atom_index);
+            }
         }
 #if GMX_SIMD_HAVE_REAL
         else if (ftype == F_ANGLES && bUseSIMD && computeForcesOnly)
@@ -502,7 +554,7 @@ calc_one_bond(int thread,
            extended to support calling from multiple threads. */
         do_pairs(ftype, nbn, iatoms+nb0, idef->iparams, x, f, fshift,
                  pbc, g, lambda, dvdl, md, fr,
-                 computeForcesOnly, grpp, global_atom_index);
+                 computeForcesOnly, useFreeEnergy, grpp, global_atom_index);
         v = 0;
     }
 
@@ -516,6 +568,71 @@ calc_one_bond(int thread,
 
 } // namespace
 
+/*! \brief Compute the bonded part of the listed forces for one thread task
+ */
+static void
+calcBondedForcesThread(int               thread,
+                       const t_idef     *idef,
+                       const rvec        x[],
+                       const t_forcerec *fr,
+                       const t_pbc      *pbc_null,
+                       const t_graph    *g,
+                       gmx_enerdata_t   *enerd,
+                       t_nrnb           *nrnb,
+                       const real       *lambda,
+                       real             *dvdl,
+                       const t_mdatoms  *md,
+                       t_fcdata         *fcd,
+                       gmx_bool          bCalcEnerVir,
+                       int              *global_atom_index)
+{
+    bonded_threading_t *bt = fr->bondedThreading;
+
+    f_thread_t         &threadBuffers = *bt->f_t[thread];
+    int                 ftype;
+    real               *epot, v;
+    /* thread stuff */
+    rvec               *fshift;
+    real               *dvdlt;
+    gmx_grppairener_t  *grpp;
+
+    zero_thread_output(&threadBuffers);
+
+    rvec4 *ft = threadBuffers.f;
+
+    /* Thread 0 writes directly to the main output buffers.
+     * We might want to reconsider this.
+     */
+    if (thread == 0)
+    {
+        fshift = fr->fshift;
+        epot   = enerd->term;
+        grpp   = &enerd->grpp;
+        dvdlt  = dvdl;
+    }
+    else
+    {
+        fshift = threadBuffers.fshift;
+        epot   = threadBuffers.ener;
+        grpp   = &threadBuffers.grpp;
+        dvdlt  = threadBuffers.dvdl;
+    }
+    /* Loop over all bonded force types to calculate the bonded forces */
+    for (ftype = 0; (ftype < F_NRE); ftype++)
+    {
+        if (idef->il[ftype].nr > 0 && ftype_is_bonded_potential(ftype))
+        {
+            v = calc_one_bond(thread, ftype, idef,
+                              bt->workDivision, x,
+                              ft, fshift, fr, pbc_null, g, grpp,
+                              nrnb, lambda, dvdlt,
+                              md, fcd, bCalcEnerVir,
+                              global_atom_index);
+            epot[ftype] += v;
+        }
+    }
+}
+
 /*! \brief Compute the bonded part of the listed forces, parallelized over threads
  */
 static void
@@ -540,49 +657,9 @@ calcBondedForces(const t_idef     *idef,
     {
         try
         {
-            f_thread_t        &threadBuffers = *bt->f_t[thread];
-            int                ftype;
-            real              *epot, v;
-            /* thread stuff */
-            rvec              *fshift;
-            real              *dvdlt;
-            gmx_grppairener_t *grpp;
-
-            zero_thread_output(&threadBuffers);
-
-            rvec4 *ft = threadBuffers.f;
-
-            /* Thread 0 writes directly to the main output buffers.
-             * We might want to reconsider this.
-             */
-            if (thread == 0)
-            {
-                fshift = fr->fshift;
-                epot   = enerd->term;
-                grpp   = &enerd->grpp;
-                dvdlt  = dvdl;
-            }
-            else
-            {
-                fshift = threadBuffers.fshift;
-                epot   = threadBuffers.ener;
-                grpp   = &threadBuffers.grpp;
-                dvdlt  = threadBuffers.dvdl;
-            }
-            /* Loop over all bonded force types to calculate the bonded forces */
-            for (ftype = 0; (ftype < F_NRE); ftype++)
-            {
-                if (idef->il[ftype].nr > 0 && ftype_is_bonded_potential(ftype))
-                {
-                    v = calc_one_bond(thread, ftype, idef,
-                                      fr->bondedThreading->workDivision, x,
-                                      ft, fshift, fr, pbc_null, g, grpp,
-                                      nrnb, lambda, dvdlt,
-                                      md, fcd, bCalcEnerVir,
-                                      global_atom_index);
-                    epot[ftype] += v;
-                }
-            }
+            calcBondedForcesThread(thread, idef, x, fr, pbc_null, g,
+                                   enerd, nrnb, lambda, dvdl, md, fcd,
+                                   bCalcEnerVir, global_atom_index);
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
@@ -610,6 +687,49 @@ bool haveCpuListedForces(const t_forcerec &fr,
     return haveCpuBondeds(fr) || havePositionRestraints(idef, fcd);
 }
 
+bool canComputeBondedsAsTasks(const t_forcerec &fr,
+                              const t_fcdata   &fcd,
+                              const t_graph    *graph)
+{
+    return (haveCpuBondeds(fr) &&
+            fr.bondedThreading->allowComputingAsTasks &&
+            graph == nullptr &&
+            fcd.orires.nr == 0 &&
+            fcd.disres.nres == 0);
+}
+
+int prepareBondedTasks(const t_forcerec *fr)
+{
+    bonded_threading_t *bt = fr->bondedThreading;
+
+    bt->bondedsComputedAsTasks = true;
+    std::fill(std::begin(bt->taskDvdl), std::end(bt->taskDvdl), 0.0_real);
+
+    return bt->nthreads;
+}
+
+void calcBondedForcesTask(int               task,
+                          const t_idef     *idef,
+                          const rvec        x[],
+                          const t_forcerec *fr,
+                          const t_pbc      *pbc,
+                          gmx_enerdata_t   *enerd,
+                          t_nrnb           *nrnb,
+                          const real       *lambda,
+                          const t_mdatoms  *md,
+                          t_fcdata         *fcd,
+                          int              *global_atom_index,
+                          int               force_flags)
+{
+    GMX_ASSERT(fr->bondedThreading->bondedsComputedAsTasks, "prepareBondedTasks() should be called before computing bonded tasks");
+
+    const bool bCalcEnerVir = ((force_flags & (GMX_FORCE_VIRIAL | GMX_FORCE_ENERGY)) != 0);
+
+    calcBondedForcesThread(task, idef, x, fr, fr->bMolPBC ? pbc : nullptr, nullptr,
+                           enerd, nrnb, lambda, fr->bondedThreading->taskDvdl,
+                           md, fcd, bCalcEnerVir, global_atom_index);
+}
+
 void calc_listed(const t_commrec             *cr,
                  const gmx_multisim_t *ms,
                  struct gmx_wallcycle        *wcycle,
@@ -697,8 +817,19 @@ void calc_listed(const t_commrec             *cr,
         /* The dummy array is to have a place to store the dhdl at other values
            of lambda, which will be thrown away in the end */
         real dvdl[efptNR] = {0};
-        calcBondedForces(idef, x, fr, pbc_null, g, enerd, nrnb, lambda, dvdl, md,
-                         fcd, bCalcEnerVir, global_atom_index);
+        if (bt->bondedsComputedAsTasks)
+        {
+            /* The forces have been computed as tasks overlapping with
+             * the non-bonded kernels, we only need to reduce them.
+             */
+            std::copy(std::begin(bt->taskDvdl), std::end(bt->taskDvdl), dvdl);
+            bt->bondedsComputedAsTasks = false;
+        }
+        else
+        {
+            calcBondedForces(idef, x, fr, pbc_null, g, enerd, nrnb, lambda, dvdl, md,
+                             fcd, bCalcEnerVir, global_atom_index);
+        }
         wallcycle_sub_stop(wcycle, ewcsLISTED);
 
         wallcycle_sub_start(wcycle, ewcsLISTED_BUF_OPS);
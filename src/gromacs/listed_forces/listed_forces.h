@@ -173,4 +173,45 @@ bool haveCpuListedForces(const t_forcerec &fr,
                          const t_idef     &idef,
                          const t_fcdata   &fcd);
 
+/*! \brief Returns whether the CPU bonded forces can be computed as tasks
+ * that overlap with other force work within the rank.
+ *
+ * This requires that the bonded interactions do not depend on work
+ * done before the bonded force calculation in calc_listed(), which is
+ * the case without orientation and distance restraints and when the
+ * molecules do not need to be made whole with \p graph.
+ * Setting the environment variable GMX_DISABLE_BONDED_TASKS turns
+ * this off.
+ */
+bool canComputeBondedsAsTasks(const t_forcerec &fr,
+                              const t_fcdata   &fcd,
+                              const t_graph    *graph);
+
+/*! \brief Prepares for computing the bonded forces with calcBondedForcesTask()
+ *
+ * The next call to calc_listed() will reduce the task output instead
+ * of computing the bonded forces itself.
+ *
+ * \returns the number of bonded tasks, all of which need to be computed
+ */
+int prepareBondedTasks(const t_forcerec *fr);
+
+/*! \brief Computes the bonded forces and energies of task \p task into
+ * the thread-local output buffers.
+ *
+ * Different tasks can be computed concurrently, in any order and by
+ * any thread. \p pbc should be set up as in do_force_lowlevel(). */
+void calcBondedForcesTask(int                  task,
+                          const t_idef        *idef,
+                          const rvec           x[],
+                          const t_forcerec    *fr,
+                          const struct t_pbc  *pbc,
+                          gmx_enerdata_t      *enerd,
+                          t_nrnb              *nrnb,
+                          const real          *lambda,
+                          const t_mdatoms     *md,
+                          struct t_fcdata     *fcd,
+                          int                 *global_atom_index,
+                          int                  force_flags);
+
 #endif
@@ -149,6 +149,13 @@ struct bonded_threading_t
 
     //! Work division for free-energy foreign lambda calculations, always uses 1 thread
     WorkDivision foreignLambdaWorkDivision;
+
+    //! Whether the bonded forces may be computed as tasks in the thread team of the non-bonded kernel
+    bool allowComputingAsTasks = true;
+    //! Whether the bonded forces of this step have been computed as tasks, calc_listed() then only reduces them
+    bool bondedsComputedAsTasks = false;
+    //! dV/dlambda output of task 0 when computing the bonded forces as tasks
+    real taskDvdl[efptNR];
 };
 
 
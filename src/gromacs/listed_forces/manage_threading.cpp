@@ -569,5 +569,14 @@ bonded_threading_t *init_bonded_threading(FILE      *fplog,
         bt->max_nthread_uniform = max_nthread_uniform;
     }
 
+    if (getenv("GMX_DISABLE_BONDED_TASKS") != nullptr)
+    {
+        bt->allowComputingAsTasks = false;
+        if (fplog != nullptr)
+        {
+            fprintf(fplog, "\nNot computing bonded forces as tasks of the non-bonded kernel, as requested by env.var.\n");
+        }
+    }
+
     return bt;
 }
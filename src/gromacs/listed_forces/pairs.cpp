@@ -45,6 +45,7 @@
 
 #include "pairs.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "gromacs/math/functions.h"
@@ -68,10 +69,23 @@
 
 using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
 
-/*! \brief Issue a warning if a listed interaction is beyond a table limit */
+/*! \brief Whether the table limit warning has been issued
+ *
+ * This flag isn't race free. But it doesn't matter because if a race
+ * occurs the only disadvantage is that the warning is printed twice.
+ */
+static gmx_bool warned_rlimit = FALSE;
+
+/*! \brief Issue a warning, only once, if a listed interaction is beyond a table limit */
 static void
 warning_rlimit(const rvec *x, int ai, int aj, int * global_atom_index, real r, real rlimit)
 {
+    if (warned_rlimit)
+    {
+        return;
+    }
+    warned_rlimit = TRUE;
+
     gmx_warning("Listed nonbonded interaction between particles %d and %d\n"
                 "at distance %.3f which is larger than the table limit %.3f nm.\n\n"
                 "This is likely either a 1,4 interaction, or a listed interaction inside\n"
@@ -356,7 +370,6 @@ do_pairs_general(int ftype, int nbonds,
     real             fscal, velec, vvdw;
     real *           energygrp_elec;
     real *           energygrp_vdw;
-    static gmx_bool  warned_rlimit = FALSE;
     /* Free energy stuff */
     gmx_bool         bFreeEnergy;
     real             LFC[2], LFV[2], DLF[2], lfac_coul[2], lfac_vdw[2], dlfac_coul[2], dlfac_vdw[2];
@@ -476,13 +489,7 @@ do_pairs_general(int ftype, int nbonds,
 
         if (r2 >= fr->pairsTable->r*fr->pairsTable->r)
         {
-            /* This check isn't race free. But it doesn't matter because if a race occurs the only
-             * disadvantage is that the warning is printed twice */
-            if (!warned_rlimit)
-            {
-                warning_rlimit(x, ai, aj, global_atom_index, sqrt(r2), fr->pairsTable->r);
-                warned_rlimit = TRUE;
-            }
+            warning_rlimit(x, ai, aj, global_atom_index, sqrt(r2), fr->pairsTable->r);
             continue;
         }
 
@@ -532,36 +539,60 @@ do_pairs_general(int ftype, int nbonds,
 /*! \brief Calculate pairs, only for plain-LJ + plain Coulomb normal type.
  *
  * This function is templated for real/SimdReal and for optimization.
+ * Supports F_LJ14 without free-energy perturbation, F_LJC14_Q and
+ * F_LJC_PAIRS_NB. With \p computeEnergyAndVirial the energies are
+ * accumulated per energy-group pair and, when \p pbcForShifts is not
+ * nullptr, the shift forces are added. The graph is not supported.
+ * As in the general kernel, pairs beyond the table limit are skipped.
  */
-template<typename T, int pack_size,
+template<bool computeEnergyAndVirial, typename T, int pack_size,
          typename pbc_type>
 static void
-do_pairs_simple(int nbonds,
+do_pairs_simple(int ftype, int nbonds,
                 const t_iatom iatoms[], const t_iparams iparams[],
-                const rvec x[], rvec4 f[],
-                const pbc_type pbc,
-                const t_mdatoms *md,
-                const real scale_factor)
+                const rvec x[], rvec4 f[], rvec fshift[],
+                const pbc_type pbc, const t_pbc *pbcForShifts,
+                const t_mdatoms *md, const t_forcerec *fr,
+                gmx_grppairener_t *grppener, int *global_atom_index)
 {
     const int nfa1 = 1 + 2;
 
     T         six(6);
     T         twelve(12);
-    T         ef(scale_factor);
+    T         rlimit2(fr->pairsTable->r*fr->pairsTable->r);
+
+    const real epsfac = fr->ic->epsfac;
 
 #if GMX_SIMD_HAVE_REAL
     alignas(GMX_SIMD_ALIGNMENT) std::int32_t  ai[pack_size];
     alignas(GMX_SIMD_ALIGNMENT) std::int32_t  aj[pack_size];
     alignas(GMX_SIMD_ALIGNMENT) real          coeff[3*pack_size];
+    alignas(GMX_SIMD_ALIGNMENT) real          buf[3*pack_size];
 #else
     std::int32_t   ai[pack_size];
     std::int32_t   aj[pack_size];
     real           coeff[3*pack_size];
+    real           buf[3*pack_size];
 #endif
 
+    real *energygrp_elec = nullptr;
+    real *energygrp_vdw  = nullptr;
+    if (computeEnergyAndVirial)
+    {
+        const bool isNonbondedPair = (ftype == F_LJC_PAIRS_NB);
+        energygrp_elec = grppener->ener[isNonbondedPair ? egCOULSR : egCOUL14].data();
+        energygrp_vdw  = grppener->ener[isNonbondedPair ? egLJSR : egLJ14].data();
+    }
+    /* With a single energy group we can sum the energies in SIMD registers */
+    const bool haveSingleEnergyGroup = (md->nenergrp == 1);
+    T          velecSum(0);
+    T          vvdwSum(0);
+
     /* nbonds is #pairs*nfa1, here we step pack_size pairs */
     for (int i = 0; i < nbonds; i += pack_size*nfa1)
     {
+        const int numPairs = std::min(pack_size, (nbonds - i)/nfa1);
+
         /* Collect atoms for pack_size pairs.
          * iu indexes into iatoms, we should not let iu go beyond nbonds.
          */
@@ -572,11 +603,27 @@ do_pairs_simple(int nbonds,
             ai[s]     = iatoms[iu + 1];
             aj[s]     = iatoms[iu + 2];
 
-            if (i + s*nfa1 < nbonds)
+            if (s < numPairs)
             {
-                coeff[0*pack_size + s] = iparams[itype].lj14.c6A;
-                coeff[1*pack_size + s] = iparams[itype].lj14.c12A;
-                coeff[2*pack_size + s] = md->chargeA[ai[s]]*md->chargeA[aj[s]];
+                const t_iparams &ip = iparams[itype];
+                switch (ftype)
+                {
+                    case F_LJ14:
+                        coeff[0*pack_size + s] = ip.lj14.c6A;
+                        coeff[1*pack_size + s] = ip.lj14.c12A;
+                        coeff[2*pack_size + s] = md->chargeA[ai[s]]*md->chargeA[aj[s]]*epsfac*fr->fudgeQQ;
+                        break;
+                    case F_LJC14_Q:
+                        coeff[0*pack_size + s] = ip.ljc14.c6;
+                        coeff[1*pack_size + s] = ip.ljc14.c12;
+                        coeff[2*pack_size + s] = ip.ljc14.qi*ip.ljc14.qj*epsfac*ip.ljc14.fqq;
+                        break;
+                    default:
+                        coeff[0*pack_size + s] = ip.ljcnb.c6;
+                        coeff[1*pack_size + s] = ip.ljcnb.c12;
+                        coeff[2*pack_size + s] = ip.ljcnb.qi*ip.ljcnb.qj*epsfac;
+                        break;
+                }
 
                 /* Avoid indexing the iatoms array out of bounds.
                  * We pad the coordinate indices with the last atom pair.
@@ -604,23 +651,42 @@ do_pairs_simple(int nbonds,
         T c12   = load<T>(coeff + 1*pack_size);
         T qq    = load<T>(coeff + 2*pack_size);
 
-        /* We could save these operations by storing 6*C6,12*C12 */
-        c6             = six*c6;
-        c12            = twelve*c12;
-
         T dr[DIM];
         pbc_dx_aiuc(pbc, xi, xj, dr);
 
         T rsq   = dr[XX]*dr[XX] + dr[YY]*dr[YY] + dr[ZZ]*dr[ZZ];
+
+        /* Pairs beyond the table limit are skipped by zeroing their
+         * coefficients. This should not happen in a stable simulation,
+         * so we only look up the pair to warn about in scalar code.
+         */
+        if (anyTrue(rlimit2 <= rsq))
+        {
+            store(buf, rsq);
+            for (int s = 0; s < numPairs; s++)
+            {
+                if (buf[s] >= fr->pairsTable->r*fr->pairsTable->r)
+                {
+                    warning_rlimit(x, ai[s], aj[s], global_atom_index,
+                                   std::sqrt(buf[s]), fr->pairsTable->r);
+                }
+            }
+            c6  = selectByMask(c6, rsq < rlimit2);
+            c12 = selectByMask(c12, rsq < rlimit2);
+            qq  = selectByMask(qq, rsq < rlimit2);
+        }
+
         T rinv  = gmx::invsqrt(rsq);
         T rinv2 = rinv*rinv;
         T rinv6 = rinv2*rinv2*rinv2;
 
-        /* Calculate the Coulomb force * r */
-        T cfr   = ef*qq*rinv;
+        /* Calculate the Coulomb force * r, which is also the energy */
+        T cfr   = qq*rinv;
 
-        /* Calculate the LJ force * r and add it to the Coulomb part */
-        T fr    = gmx::fma(fms(c12, rinv6, c6), rinv6, cfr);
+        /* Calculate the LJ force * r and add it to the Coulomb part.
+         * We could save two operations by storing 6*C6,12*C12.
+         */
+        T fr    = gmx::fma(fms(twelve*c12, rinv6, six*c6), rinv6, cfr);
 
         T finvr = fr*rinv2;
         T fx    = finvr*dr[XX];
@@ -633,7 +699,102 @@ do_pairs_simple(int nbonds,
          */
         transposeScatterIncrU<4>(reinterpret_cast<real *>(f), ai, fx, fy, fz);
         transposeScatterDecrU<4>(reinterpret_cast<real *>(f), aj, fx, fy, fz);
+
+        if (computeEnergyAndVirial)
+        {
+            T vvdw  = fms(c12, rinv6, c6)*rinv6;
+
+            if (haveSingleEnergyGroup)
+            {
+                velecSum = velecSum + cfr;
+                vvdwSum  = vvdwSum + vvdw;
+            }
+            else
+            {
+                store(buf + 0*pack_size, cfr);
+                store(buf + 1*pack_size, vvdw);
+                for (int s = 0; s < numPairs; s++)
+                {
+                    int gid = GID(md->cENER[ai[s]], md->cENER[aj[s]], md->nenergrp);
+                    energygrp_elec[gid] += buf[0*pack_size + s];
+                    energygrp_vdw[gid]  += buf[1*pack_size + s];
+                }
+            }
+
+            /* Only pairs that are shifted by PBC contribute to the shift
+             * forces. These are rare, so we only check for their presence
+             * here and determine the shift index in scalar code.
+             */
+            if (pbcForShifts != nullptr &&
+                anyTrue(dr[XX] != xi[XX] - xj[XX] ||
+                        dr[YY] != xi[YY] - xj[YY] ||
+                        dr[ZZ] != xi[ZZ] - xj[ZZ]))
+            {
+                store(buf + 0*pack_size, fx);
+                store(buf + 1*pack_size, fy);
+                store(buf + 2*pack_size, fz);
+                for (int s = 0; s < numPairs; s++)
+                {
+                    rvec dx;
+                    int  fshift_index = pbc_dx_aiuc(pbcForShifts, x[ai[s]], x[aj[s]], dx);
+                    if (fshift_index != CENTRAL)
+                    {
+                        for (int m = 0; m < DIM; m++)
+                        {
+                            fshift[fshift_index][m] += buf[m*pack_size + s];
+                            fshift[CENTRAL][m]      -= buf[m*pack_size + s];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (computeEnergyAndVirial && haveSingleEnergyGroup)
+    {
+        energygrp_elec[0] += reduce(velecSum);
+        energygrp_vdw[0]  += reduce(vvdwSum);
+    }
+}
+
+/*! \brief Set up the PBC and call the SIMD or plain-C simple pair kernel */
+template<bool computeEnergyAndVirial>
+static void
+do_pairs_simple_pbc(int ftype, int nbonds,
+                    const t_iatom iatoms[], const t_iparams iparams[],
+                    const rvec x[], rvec4 f[], rvec fshift[],
+                    const t_pbc *pbc,
+                    const t_mdatoms *md, const t_forcerec *fr,
+                    gmx_grppairener_t *grppener, int *global_atom_index)
+{
+#if GMX_SIMD
+    alignas(GMX_SIMD_ALIGNMENT) real pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+    set_pbc_simd(pbc, pbc_simd);
+
+    do_pairs_simple<computeEnergyAndVirial, SimdReal, GMX_SIMD_REAL_WIDTH,
+                    const real *>(ftype, nbonds, iatoms, iparams,
+                                  x, f, fshift, pbc_simd, pbc,
+                                  md, fr, grppener, global_atom_index);
+#else
+    /* This construct is needed because pbc_dx_aiuc doesn't accept pbc=NULL */
+    t_pbc        pbc_no;
+    const t_pbc *pbc_nonnull;
+
+    if (pbc != nullptr)
+    {
+        pbc_nonnull   = pbc;
     }
+    else
+    {
+        set_pbc(&pbc_no, epbcNONE, nullptr);
+        pbc_nonnull   = &pbc_no;
+    }
+
+    do_pairs_simple<computeEnergyAndVirial, real, 1,
+                    const t_pbc *>(ftype, nbonds, iatoms, iparams,
+                                   x, f, fshift, pbc_nonnull, pbc,
+                                   md, fr, grppener, global_atom_index);
+#endif
 }
 
 /*! \brief Calculate all listed pair interactions */
@@ -646,49 +807,35 @@ do_pairs(int ftype, int nbonds,
          const t_mdatoms *md,
          const t_forcerec *fr,
          const gmx_bool computeForcesOnly,
+         const gmx_bool havePerturbedPairs,
          gmx_grppairener_t *grppener,
          int *global_atom_index)
 {
-    if (ftype == F_LJ14 &&
-        fr->ic->vdwtype != evdwUSER && !EEL_USER(fr->ic->eeltype) &&
-        computeForcesOnly)
+    /* We use a fast code-path for plain LJ and Coulomb pairs without
+     * perturbed pairs in the list.
+     * The shift forces with a graph are only supported by the general code.
+     *
+     * TODO: For the virial it would be cheaper to directly calculate
+     * and sum the virial for the shifts instead of the shift forces.
+     * But we should do this at once for the angles and dihedrals as well.
+     */
+    const bool useSimpleKernel =
+        ((ftype == F_LJ14 || ftype == F_LJC14_Q || ftype == F_LJC_PAIRS_NB) &&
+         fr->ic->vdwtype != evdwUSER && !EEL_USER(fr->ic->eeltype) &&
+         !(ftype == F_LJ14 && havePerturbedPairs) &&
+         (computeForcesOnly || g == nullptr));
+
+    if (useSimpleKernel && computeForcesOnly)
     {
-        /* We use a fast code-path for plain LJ 1-4 without FEP.
-         *
-         * TODO: Add support for energies (straightforward) and virial
-         * in the SIMD template. For the virial it's inconvenient to store
-         * the force sums for the shifts and we should directly calculate
-         * and sum the virial for the shifts. But we should do this
-         * at once for the angles and dihedrals as well.
-         */
-#if GMX_SIMD
-        alignas(GMX_SIMD_ALIGNMENT) real pbc_simd[9*GMX_SIMD_REAL_WIDTH];
-        set_pbc_simd(pbc, pbc_simd);
-
-        do_pairs_simple<SimdReal, GMX_SIMD_REAL_WIDTH,
-                        const real *>(nbonds, iatoms, iparams,
-                                      x, f, pbc_simd,
-                                      md, fr->ic->epsfac*fr->fudgeQQ);
-#else
-        /* This construct is needed because pbc_dx_aiuc doesn't accept pbc=NULL */
-        t_pbc        pbc_no;
-        const t_pbc *pbc_nonnull;
-
-        if (pbc != nullptr)
-        {
-            pbc_nonnull   = pbc;
-        }
-        else
-        {
-            set_pbc(&pbc_no, epbcNONE, nullptr);
-            pbc_nonnull   = &pbc_no;
-        }
-
-        do_pairs_simple<real, 1,
-                        const t_pbc *>(nbonds, iatoms, iparams,
-                                       x, f, pbc_nonnull,
-                                       md, fr->ic->epsfac*fr->fudgeQQ);
-#endif
+        do_pairs_simple_pbc<false>(ftype, nbonds, iatoms, iparams,
+                                   x, f, fshift, pbc,
+                                   md, fr, grppener, global_atom_index);
+    }
+    else if (useSimpleKernel)
+    {
+        do_pairs_simple_pbc<true>(ftype, nbonds, iatoms, iparams,
+                                  x, f, fshift, pbc,
+                                  md, fr, grppener, global_atom_index);
     }
     else
     {
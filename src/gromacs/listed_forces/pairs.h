@@ -58,6 +58,8 @@ struct t_pbc;
 /*! \brief Calculate VdW/charge listed pair interactions (usually 1-4
  * interactions).
  *
+ * havePerturbedPairs tells whether the list contains perturbed pairs,
+ * which require the free-energy code path.
  * global_atom_index is only passed for printing error messages.
  */
 void
@@ -65,7 +67,8 @@ do_pairs(int ftype, int nbonds, const t_iatom iatoms[], const t_iparams iparams[
          const rvec x[], rvec4 f[], rvec fshift[],
          const struct t_pbc *pbc, const struct t_graph *g,
          const real *lambda, real *dvdl, const t_mdatoms *md, const t_forcerec *fr,
-         gmx_bool computeForcesOnly, gmx_grppairener_t *grppener,
+         gmx_bool computeForcesOnly, gmx_bool havePerturbedPairs,
+         gmx_grppairener_t *grppener,
          int *global_atom_index);
 
 #endif
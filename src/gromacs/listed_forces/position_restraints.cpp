@@ -49,9 +49,13 @@
 #include <cassert>
 #include <cmath>
 
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/enerdata.h"
 #include "gromacs/mdtypes/forceoutput.h"
 #include "gromacs/mdtypes/forcerec.h"
@@ -60,7 +64,9 @@
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/idef.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 
 struct gmx_wallcycle;
@@ -179,6 +185,58 @@ real do_fbposres_cylinder(int fbdim, rvec fm, rvec dx, real rfb, real kk, gmx_bo
     return v;
 }
 
+/*! \brief The minimum number of restraints per thread, to limit the threading overhead */
+constexpr int c_minRestraintsPerThread = 64;
+
+/*! \brief Returns the number of threads to use for \p numRestraints restraints
+ *
+ * When forces are computed, threads work on contiguous ranges of
+ * restraints. To avoid races on the forces, we then require that
+ * the restrained atoms are strictly increasing, which is the case
+ * for restraints generated from the topology, also with domain
+ * decomposition. Otherwise a single thread is used.
+ */
+int numRestraintThreads(int numRestraints, const t_iatom forceatoms[],
+                        bool computeForce)
+{
+    int numThreads = std::min(gmx_omp_nthreads_get(emntBonded),
+                              numRestraints/c_minRestraintsPerThread);
+    if (numThreads <= 1)
+    {
+        return 1;
+    }
+
+    if (computeForce)
+    {
+        for (int r = 1; r < numRestraints; r++)
+        {
+            if (forceatoms[2*r + 1] <= forceatoms[2*r - 1])
+            {
+                return 1;
+            }
+        }
+    }
+
+    return numThreads;
+}
+
+/*! \brief Returns the start of the range of iatoms entries for \p thread */
+int restraintRangeStart(int numRestraints, int numThreads, int thread)
+{
+    return 2*((numRestraints*thread)/numThreads);
+}
+
+/*! \brief Per-thread output for (flat-bottomed) position restraints */
+struct RestraintThreadOutput
+{
+    //! The potential energy
+    real energy    = 0;
+    //! dV/dlambda
+    real dvdlambda = 0;
+    //! The diagonal of the virial
+    rvec virial    = { 0 };
+};
+
 /*! \brief Compute energies and forces for flat-bottomed position restraints
  *
  * Returns the flat-bottomed potential. Same PBC treatment as in
@@ -191,12 +249,8 @@ real fbposres(int nbonds,
               int refcoord_scaling, int ePBC, const rvec com)
 /* compute flat-bottomed positions restraints */
 {
-    int              i, ai, m, d, type, npbcdim = 0, fbdim;
-    const t_iparams *pr;
-    real             kk, v;
-    real             dr, dr2, rfb, rfb2, fact;
-    rvec             com_sc, rdist, dx, dpdl, fm;
-    gmx_bool         bInvert;
+    int              m, d, npbcdim = 0;
+    rvec             com_sc;
 
     npbcdim = ePBC2npbcdim(ePBC);
     GMX_ASSERT((ePBC == epbcNONE) ==  (npbcdim == 0), "");
@@ -213,95 +267,125 @@ real fbposres(int nbonds,
         }
     }
 
-    rvec *f      = as_rvec_array(forceWithVirial->force_.data());
-    real  vtot   = 0.0;
-    rvec  virial = { 0 };
-    for (i = 0; (i < nbonds); )
+    rvec *f = as_rvec_array(forceWithVirial->force_.data());
+
+    const int                          numRestraints = nbonds/2;
+    const int                          numThreads    = numRestraintThreads(numRestraints, forceatoms, true);
+    std::vector<RestraintThreadOutput> threadOutput(numThreads);
+
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
     {
-        type = forceatoms[i++];
-        ai   = forceatoms[i++];
-        pr   = &forceparams[type];
-
-        /* same calculation as for normal posres, but with identical A and B states, and lambda==0 */
-        posres_dx(x[ai], forceparams[type].fbposres.pos0, forceparams[type].fbposres.pos0,
-                  com_sc, com_sc, 0.0,
-                  pbc, refcoord_scaling, npbcdim,
-                  dx, rdist, dpdl);
-
-        clear_rvec(fm);
-        v = 0.0;
-
-        kk   = pr->fbposres.k;
-        rfb  = pr->fbposres.r;
-        rfb2 = gmx::square(rfb);
-
-        /* with rfb<0, push particle out of the sphere/cylinder/layer */
-        bInvert = FALSE;
-        if (rfb < 0.)
+        try
         {
-            bInvert = TRUE;
-            rfb     = -rfb;
-        }
+            real  vtot   = 0.0;
+            real *virial = threadOutput[thread].virial;
 
-        switch (pr->fbposres.geom)
-        {
-            case efbposresSPHERE:
-                /* spherical flat-bottom posres */
-                dr2 = norm2(dx);
-                if (dr2 > 0.0 &&
-                    ( (dr2 > rfb2 && !bInvert ) || (dr2 < rfb2 && bInvert ) )
-                    )
+            const int start = restraintRangeStart(numRestraints, numThreads, thread);
+            const int end   = restraintRangeStart(numRestraints, numThreads, thread + 1);
+            for (int i = start; (i < end); )
+            {
+                int              type = forceatoms[i++];
+                int              ai   = forceatoms[i++];
+                const t_iparams *pr   = &forceparams[type];
+                int              fbdim;
+                real             dr, dr2, fact;
+                rvec             rdist, dx, dpdl, fm;
+
+                /* same calculation as for normal posres, but with identical A and B states, and lambda==0 */
+                posres_dx(x[ai], forceparams[type].fbposres.pos0, forceparams[type].fbposres.pos0,
+                          com_sc, com_sc, 0.0,
+                          pbc, refcoord_scaling, npbcdim,
+                          dx, rdist, dpdl);
+
+                clear_rvec(fm);
+                real v = 0.0;
+
+                real kk   = pr->fbposres.k;
+                real rfb  = pr->fbposres.r;
+                real rfb2 = gmx::square(rfb);
+
+                /* with rfb<0, push particle out of the sphere/cylinder/layer */
+                gmx_bool bInvert = FALSE;
+                if (rfb < 0.)
                 {
-                    dr   = std::sqrt(dr2);
-                    v    = 0.5*kk*gmx::square(dr - rfb);
-                    fact = -kk*(dr-rfb)/dr; /* Force pointing to the center pos0 */
-                    svmul(fact, dx, fm);
+                    bInvert = TRUE;
+                    rfb     = -rfb;
                 }
-                break;
-            case efbposresCYLINDERX:
-                /* cylindrical flat-bottom posres in y-z plane. fm[XX] = 0. */
-                fbdim = XX;
-                v     = do_fbposres_cylinder(fbdim, fm, dx, rfb, kk, bInvert);
-                break;
-            case efbposresCYLINDERY:
-                /* cylindrical flat-bottom posres in x-z plane. fm[YY] = 0. */
-                fbdim = YY;
-                v     = do_fbposres_cylinder(fbdim, fm, dx, rfb, kk, bInvert);
-                break;
-            case efbposresCYLINDER:
-            /* equivalent to efbposresCYLINDERZ for backwards compatibility */
-            case efbposresCYLINDERZ:
-                /* cylindrical flat-bottom posres in x-y plane. fm[ZZ] = 0. */
-                fbdim = ZZ;
-                v     = do_fbposres_cylinder(fbdim, fm, dx, rfb, kk, bInvert);
-                break;
-            case efbposresX: /* fbdim=XX */
-            case efbposresY: /* fbdim=YY */
-            case efbposresZ: /* fbdim=ZZ */
-                /* 1D flat-bottom potential */
-                fbdim = pr->fbposres.geom - efbposresX;
-                dr    = dx[fbdim];
-                if ( ( dr > rfb && !bInvert ) || ( 0 < dr && dr < rfb && bInvert )  )
+
+                switch (pr->fbposres.geom)
                 {
-                    v         = 0.5*kk*gmx::square(dr - rfb);
-                    fm[fbdim] = -kk*(dr - rfb);
+                    case efbposresSPHERE:
+                        /* spherical flat-bottom posres */
+                        dr2 = norm2(dx);
+                        if (dr2 > 0.0 &&
+                            ( (dr2 > rfb2 && !bInvert ) || (dr2 < rfb2 && bInvert ) )
+                            )
+                        {
+                            dr   = std::sqrt(dr2);
+                            v    = 0.5*kk*gmx::square(dr - rfb);
+                            fact = -kk*(dr-rfb)/dr; /* Force pointing to the center pos0 */
+                            svmul(fact, dx, fm);
+                        }
+                        break;
+                    case efbposresCYLINDERX:
+                        /* cylindrical flat-bottom posres in y-z plane. fm[XX] = 0. */
+                        fbdim = XX;
+                        v     = do_fbposres_cylinder(fbdim, fm, dx, rfb, kk, bInvert);
+                        break;
+                    case efbposresCYLINDERY:
+                        /* cylindrical flat-bottom posres in x-z plane. fm[YY] = 0. */
+                        fbdim = YY;
+                        v     = do_fbposres_cylinder(fbdim, fm, dx, rfb, kk, bInvert);
+                        break;
+                    case efbposresCYLINDER:
+                    /* equivalent to efbposresCYLINDERZ for backwards compatibility */
+                    case efbposresCYLINDERZ:
+                        /* cylindrical flat-bottom posres in x-y plane. fm[ZZ] = 0. */
+                        fbdim = ZZ;
+                        v     = do_fbposres_cylinder(fbdim, fm, dx, rfb, kk, bInvert);
+                        break;
+                    case efbposresX: /* fbdim=XX */
+                    case efbposresY: /* fbdim=YY */
+                    case efbposresZ: /* fbdim=ZZ */
+                        /* 1D flat-bottom potential */
+                        fbdim = pr->fbposres.geom - efbposresX;
+                        dr    = dx[fbdim];
+                        if ( ( dr > rfb && !bInvert ) || ( 0 < dr && dr < rfb && bInvert )  )
+                        {
+                            v         = 0.5*kk*gmx::square(dr - rfb);
+                            fm[fbdim] = -kk*(dr - rfb);
+                        }
+                        else if ( (dr < (-rfb) && !bInvert ) || ( (-rfb) < dr && dr < 0 && bInvert ))
+                        {
+                            v         = 0.5*kk*gmx::square(dr + rfb);
+                            fm[fbdim] = -kk*(dr + rfb);
+                        }
+                        break;
                 }
-                else if ( (dr < (-rfb) && !bInvert ) || ( (-rfb) < dr && dr < 0 && bInvert ))
+
+                vtot += v;
+
+                for (int m = 0; (m < DIM); m++)
                 {
-                    v         = 0.5*kk*gmx::square(dr + rfb);
-                    fm[fbdim] = -kk*(dr + rfb);
+                    f[ai][m]  += fm[m];
+                    /* Here we correct for the pbc_dx which included rdist */
+                    virial[m] -= 0.5*(dx[m] + rdist[m])*fm[m];
                 }
-                break;
-        }
-
-        vtot += v;
+            }
 
-        for (m = 0; (m < DIM); m++)
-        {
-            f[ai][m]  += fm[m];
-            /* Here we correct for the pbc_dx which included rdist */
-            virial[m] -= 0.5*(dx[m] + rdist[m])*fm[m];
+            threadOutput[thread].energy = vtot;
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    /* Reduce in a fixed order to get reproducible results */
+    real vtot   = 0.0;
+    rvec virial = { 0 };
+    for (const RestraintThreadOutput &output : threadOutput)
+    {
+        vtot += output.energy;
+        rvec_inc(virial, output.virial);
     }
 
     forceWithVirial->addVirialContribution(virial);
@@ -323,10 +407,8 @@ real posres(int nbonds,
             real lambda, real *dvdlambda,
             int refcoord_scaling, int ePBC, const rvec comA, const rvec comB)
 {
-    int              i, ai, m, d, type, npbcdim = 0;
-    const t_iparams *pr;
-    real             kk, fm;
-    rvec             comA_sc, comB_sc, rdist, dpdl, dx;
+    int              m, d, npbcdim = 0;
+    rvec             comA_sc, comB_sc;
 
     npbcdim = ePBC2npbcdim(ePBC);
     GMX_ASSERT((ePBC == epbcNONE) ==  (npbcdim == 0), "");
@@ -353,37 +435,68 @@ real posres(int nbonds,
         GMX_ASSERT(forceWithVirial != nullptr, "When forces are requested we need a force object");
         f              = as_rvec_array(forceWithVirial->force_.data());
     }
-    real        vtot   = 0.0;
-    /* Use intermediate virial buffer to reduce reduction rounding errors */
-    rvec        virial = { 0 };
-    for (i = 0; (i < nbonds); )
-    {
-        type = forceatoms[i++];
-        ai   = forceatoms[i++];
-        pr   = &forceparams[type];
 
-        /* return dx, rdist, and dpdl */
-        posres_dx(x[ai], forceparams[type].posres.pos0A, forceparams[type].posres.pos0B,
-                  comA_sc, comB_sc, lambda,
-                  pbc, refcoord_scaling, npbcdim,
-                  dx, rdist, dpdl);
+    const int                          numRestraints = nbonds/2;
+    const int                          numThreads    = numRestraintThreads(numRestraints, forceatoms, computeForce);
+    std::vector<RestraintThreadOutput> threadOutput(numThreads);
 
-        for (m = 0; (m < DIM); m++)
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
         {
-            kk          = L1*pr->posres.fcA[m] + lambda*pr->posres.fcB[m];
-            fm          = -kk*dx[m];
-            vtot       += 0.5*kk*dx[m]*dx[m];
-            *dvdlambda +=
-                0.5*(pr->posres.fcB[m] - pr->posres.fcA[m])*dx[m]*dx[m]
-                + fm*dpdl[m];
-
-            /* Here we correct for the pbc_dx which included rdist */
-            if (computeForce)
+            real  vtot   = 0.0;
+            real  dvdl   = 0.0;
+            /* Use intermediate virial buffer to reduce reduction rounding errors */
+            real *virial = threadOutput[thread].virial;
+
+            const int start = restraintRangeStart(numRestraints, numThreads, thread);
+            const int end   = restraintRangeStart(numRestraints, numThreads, thread + 1);
+            for (int i = start; (i < end); )
             {
-                f[ai][m]  += fm;
-                virial[m] -= 0.5*(dx[m] + rdist[m])*fm;
+                int              type = forceatoms[i++];
+                int              ai   = forceatoms[i++];
+                const t_iparams *pr   = &forceparams[type];
+                rvec             rdist, dpdl, dx;
+
+                /* return dx, rdist, and dpdl */
+                posres_dx(x[ai], forceparams[type].posres.pos0A, forceparams[type].posres.pos0B,
+                          comA_sc, comB_sc, lambda,
+                          pbc, refcoord_scaling, npbcdim,
+                          dx, rdist, dpdl);
+
+                for (int m = 0; (m < DIM); m++)
+                {
+                    real kk     = L1*pr->posres.fcA[m] + lambda*pr->posres.fcB[m];
+                    real fm     = -kk*dx[m];
+                    vtot       += 0.5*kk*dx[m]*dx[m];
+                    dvdl       +=
+                        0.5*(pr->posres.fcB[m] - pr->posres.fcA[m])*dx[m]*dx[m]
+                        + fm*dpdl[m];
+
+                    /* Here we correct for the pbc_dx which included rdist */
+                    if (computeForce)
+                    {
+                        f[ai][m]  += fm;
+                        virial[m] -= 0.5*(dx[m] + rdist[m])*fm;
+                    }
+                }
             }
+
+            threadOutput[thread].energy    = vtot;
+            threadOutput[thread].dvdlambda = dvdl;
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    /* Reduce in a fixed order to get reproducible results */
+    real vtot   = 0.0;
+    rvec virial = { 0 };
+    for (const RestraintThreadOutput &output : threadOutput)
+    {
+        vtot       += output.energy;
+        *dvdlambda += output.dvdlambda;
+        rvec_inc(virial, output.virial);
     }
 
     if (computeForce)
@@ -394,6 +507,117 @@ real posres(int nbonds,
     return vtot;
 }
 
+/*! \brief Compute the position restraint energies for all \p lambdas in one pass
+ *
+ * The energy for lambda value \p lambdas[l] is added to \p energies[l].
+ * Restraints with identical A and B states are only evaluated once.
+ */
+void posresAllLambdas(int nbonds,
+                      const t_iatom forceatoms[], const t_iparams forceparams[],
+                      const rvec x[],
+                      const struct t_pbc *pbc,
+                      gmx::ArrayRef<const real> lambdas,
+                      int refcoord_scaling, int ePBC, const rvec comA, const rvec comB,
+                      gmx::ArrayRef<double> energies)
+{
+    int              m, d, npbcdim = 0;
+    rvec             comA_sc, comB_sc;
+    bool             comIsPerturbed = false;
+
+    npbcdim = ePBC2npbcdim(ePBC);
+    GMX_ASSERT((ePBC == epbcNONE) ==  (npbcdim == 0), "");
+    if (refcoord_scaling == erscCOM)
+    {
+        clear_rvec(comA_sc);
+        clear_rvec(comB_sc);
+        for (m = 0; m < npbcdim; m++)
+        {
+            assert(npbcdim <= DIM);
+            for (d = m; d < npbcdim; d++)
+            {
+                comA_sc[m] += comA[d]*pbc->box[d][m];
+                comB_sc[m] += comB[d]*pbc->box[d][m];
+            }
+            comIsPerturbed = comIsPerturbed || (comA_sc[m] != comB_sc[m]);
+        }
+    }
+
+    const int                      numLambdas    = lambdas.ssize();
+    const int                      numRestraints = nbonds/2;
+    const int                      numThreads    = numRestraintThreads(numRestraints, forceatoms, false);
+    std::vector<std::vector<real>> threadEnergies(numThreads);
+
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            std::vector<real> &vtot = threadEnergies[thread];
+            vtot.resize(numLambdas, 0.0);
+
+            const int          start = restraintRangeStart(numRestraints, numThreads, thread);
+            const int          end   = restraintRangeStart(numRestraints, numThreads, thread + 1);
+            for (int i = start; (i < end); )
+            {
+                int         type = forceatoms[i++];
+                int         ai   = forceatoms[i++];
+                const auto &pr   = forceparams[type].posres;
+                rvec        rdist, dpdl, dx;
+
+                bool        isPerturbed = comIsPerturbed;
+                for (int m = 0; m < DIM; m++)
+                {
+                    isPerturbed = isPerturbed || (pr.pos0A[m] != pr.pos0B[m] || pr.fcA[m] != pr.fcB[m]);
+                }
+
+                if (!isPerturbed)
+                {
+                    posres_dx(x[ai], pr.pos0A, pr.pos0B,
+                              comA_sc, comB_sc, 0.0,
+                              pbc, refcoord_scaling, npbcdim,
+                              dx, rdist, dpdl);
+                    real v = 0.0;
+                    for (int m = 0; m < DIM; m++)
+                    {
+                        v += 0.5*pr.fcA[m]*dx[m]*dx[m];
+                    }
+                    for (int l = 0; l < numLambdas; l++)
+                    {
+                        vtot[l] += v;
+                    }
+                }
+                else
+                {
+                    for (int l = 0; l < numLambdas; l++)
+                    {
+                        const real lambda = lambdas[l];
+                        const real L1     = 1.0 - lambda;
+                        posres_dx(x[ai], pr.pos0A, pr.pos0B,
+                                  comA_sc, comB_sc, lambda,
+                                  pbc, refcoord_scaling, npbcdim,
+                                  dx, rdist, dpdl);
+                        for (int m = 0; m < DIM; m++)
+                        {
+                            real kk  = L1*pr.fcA[m] + lambda*pr.fcB[m];
+                            vtot[l] += 0.5*kk*dx[m]*dx[m];
+                        }
+                    }
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    /* Reduce in a fixed order to get reproducible results */
+    for (const std::vector<real> &vtot : threadEnergies)
+    {
+        for (int l = 0; l < numLambdas; l++)
+        {
+            energies[l] += vtot[l];
+        }
+    }
+}
+
 } // namespace
 
 void
@@ -434,26 +658,23 @@ posres_wrapper_lambda(struct gmx_wallcycle *wcycle,
                       const real           *lambda,
                       const t_forcerec     *fr)
 {
-    real  v;
-
     if (0 == idef->il[F_POSRES].nr)
     {
         return;
     }
 
     wallcycle_sub_start_nocount(wcycle, ewcsRESTRAINTS);
-    for (size_t i = 0; i < enerd->enerpart_lambda.size(); i++)
+    std::vector<real> lambdas(enerd->enerpart_lambda.size());
+    for (size_t i = 0; i < lambdas.size(); i++)
     {
-        real dvdl_dum = 0, lambda_dum;
-
-        lambda_dum = (i == 0 ? lambda[efptRESTRAINT] : fepvals->all_lambda[efptRESTRAINT][i-1]);
-        v          = posres<false>(idef->il[F_POSRES].nr, idef->il[F_POSRES].iatoms,
-                                   idef->iparams_posres,
-                                   x, nullptr,
-                                   fr->ePBC == epbcNONE ? nullptr : pbc, lambda_dum, &dvdl_dum,
-                                   fr->rc_scaling, fr->ePBC, fr->posres_com, fr->posres_comB);
-        enerd->enerpart_lambda[i] += v;
+        lambdas[i] = (i == 0 ? lambda[efptRESTRAINT] : fepvals->all_lambda[efptRESTRAINT][i-1]);
     }
+    posresAllLambdas(idef->il[F_POSRES].nr, idef->il[F_POSRES].iatoms,
+                     idef->iparams_posres,
+                     x,
+                     fr->ePBC == epbcNONE ? nullptr : pbc, lambdas,
+                     fr->rc_scaling, fr->ePBC, fr->posres_com, fr->posres_comB,
+                     enerd->enerpart_lambda);
     wallcycle_sub_stop(wcycle, ewcsRESTRAINTS);
 }
 
@@ -0,0 +1,304 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements test of the CMAP kernels
+ *
+ * The plain-C kernel is checked against reference data and
+ * the SIMD kernels are compared with the plain-C kernel.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/listed_forces/bonded.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/basedefinitions.h"
+
+#include "testutils/refdata.h"
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+//! Number of CMAP terms, chosen such that SIMD padding is needed
+constexpr int c_numTerms = 5;
+//! Number of atoms, the terms share atoms along a chain
+constexpr int c_numAtoms = c_numTerms + 4;
+//! Number of grid points per dimension
+constexpr int c_gridSpacing = 24;
+
+//! Output of the CMAP kernels
+struct CmapOutput
+{
+    //! Energy
+    real              energy = 0;
+    //! Forces, with padding for SIMD
+    std::vector<real> f = std::vector<real>(4*(c_numAtoms + 1), 0);
+    //! Shift forces
+    std::vector<RVec> fshift = std::vector<RVec>(SHIFTS, { 0, 0, 0 });
+};
+
+//! Test fixture for the CMAP kernels
+class CmapTest : public ::testing::Test
+{
+    protected:
+        //! Sets up a chain of atoms which crosses the periodic boundaries
+        CmapTest()
+        {
+            clear_mat(box_);
+            box_[XX][XX] = 1.2;
+            box_[YY][YY] = 1.3;
+            box_[ZZ][ZZ] = 1.1;
+            set_pbc(&pbc_, epbcXYZ, box_);
+
+            /* The bond between the second and third atom crosses the box
+             * boundary, which is the central bond of the first dihedral.
+             */
+            RVec xPrev = { 0.95, 1.1, 0.9 };
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                /* A helical-like chain with bond lengths around 0.15 nm */
+                RVec xNew = { xPrev[XX] + 0.12f,
+                              xPrev[YY] + 0.08f*std::cos(1.9f*a),
+                              xPrev[ZZ] + 0.08f*std::sin(1.9f*a) };
+                xPrev = xNew;
+                xWhole_.push_back(xNew);
+                /* Put the atom in the box, so the chain is broken over PBC */
+                for (int d = 0; d < DIM; d++)
+                {
+                    xNew[d] -= box_[d][d]*std::floor(xNew[d]/box_[d][d]);
+                }
+                x_.push_back(xNew);
+            }
+            /* Padding for SIMD loads */
+            x_.push_back({ 0, 0, 0 });
+
+            /* Use a smooth periodic grid with values and derivatives
+             * with respect to the angles in degrees.
+             */
+            cmapGrid_.grid_spacing = c_gridSpacing;
+            cmapGrid_.cmapdata.resize(2);
+            for (int t = 0; t < 2; t++)
+            {
+                std::vector<real> &cmap = cmapGrid_.cmapdata[t].cmap;
+                cmap.resize(4*c_gridSpacing*c_gridSpacing);
+                const real         a    = 3.0 + t;
+                const real         b    = 1.5 - t;
+                for (int i = 0; i < c_gridSpacing; i++)
+                {
+                    for (int j = 0; j < c_gridSpacing; j++)
+                    {
+                        const real phi = DEG2RAD*(-180 + i*360.0/c_gridSpacing);
+                        const real psi = DEG2RAD*(-180 + j*360.0/c_gridSpacing);
+                        const int  pos = i*c_gridSpacing + j;
+                        cmap[pos*4 + 0] = a*std::cos(phi) + b*std::sin(2*psi) + std::cos(phi)*std::sin(psi);
+                        cmap[pos*4 + 1] = DEG2RAD*(-a*std::sin(phi) - std::sin(phi)*std::sin(psi));
+                        cmap[pos*4 + 2] = DEG2RAD*(2*b*std::cos(2*psi) + std::cos(phi)*std::cos(psi));
+                        cmap[pos*4 + 3] = DEG2RAD*DEG2RAD*(-std::sin(phi)*std::cos(psi));
+                    }
+                }
+            }
+
+            iparams_.resize(2);
+            iparams_[0].cmap.cmapA = 0;
+            iparams_[1].cmap.cmapA = 1;
+            for (int n = 0; n < c_numTerms; n++)
+            {
+                iatoms_.push_back(n % 2);
+                for (int a = 0; a < 5; a++)
+                {
+                    iatoms_.push_back(n + a);
+                }
+            }
+        }
+
+        //! Computes the CMAP terms with the plain-C or SIMD kernel
+        CmapOutput computeCmap(bool useSimd, bool computeEnergy)
+        {
+            CmapOutput output;
+            real       dvdlambda = 0;
+            const int  nbonds    = static_cast<int>(iatoms_.size());
+            rvec4     *f         = reinterpret_cast<rvec4 *>(output.f.data());
+            if (!useSimd)
+            {
+                output.energy = cmap_dihs(nbonds, iatoms_.data(), iparams_.data(), &cmapGrid_,
+                                          as_rvec_array(x_.data()), f, as_rvec_array(output.fshift.data()),
+                                          &pbc_, nullptr, 0, &dvdlambda, nullptr, nullptr, nullptr);
+            }
+#if GMX_SIMD_HAVE_REAL
+            else if (computeEnergy)
+            {
+                output.energy = cmap_dihs_simd(nbonds, iatoms_.data(), iparams_.data(), &cmapGrid_,
+                                               as_rvec_array(x_.data()), f, as_rvec_array(output.fshift.data()),
+                                               &pbc_, nullptr, 0, &dvdlambda, nullptr, nullptr, nullptr);
+            }
+            else
+            {
+                cmap_dihs_noener_simd(nbonds, iatoms_.data(), iparams_.data(), &cmapGrid_,
+                                      as_rvec_array(x_.data()), f,
+                                      &pbc_, nullptr, 0, nullptr, nullptr, nullptr);
+            }
+#else
+            GMX_UNUSED_VALUE(computeEnergy);
+#endif
+
+            return output;
+        }
+
+        //! Coordinates
+        std::vector<RVec>      x_;
+        //! Coordinates of the chain without periodic images
+        std::vector<RVec>      xWhole_;
+        //! Box
+        matrix                 box_;
+        //! PBC
+        t_pbc                  pbc_;
+        //! The CMAP grids
+        gmx_cmap_t             cmapGrid_;
+        //! Interaction parameters
+        std::vector<t_iparams> iparams_;
+        //! CMAP interaction list
+        std::vector<t_iatom>   iatoms_;
+};
+
+TEST_F(CmapTest, PlainKernelMatchesReferenceData)
+{
+    const CmapOutput           output = computeCmap(false, true);
+
+    test::TestReferenceData    refData;
+    test::TestReferenceChecker checker(refData.rootChecker());
+    checker.setDefaultTolerance(test::relativeToleranceAsFloatingPoint(100.0, 1e-4));
+    checker.checkReal(output.energy, "Energy");
+    std::vector<RVec>          f;
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        f.emplace_back(output.f[4*a + XX], output.f[4*a + YY], output.f[4*a + ZZ]);
+    }
+    checker.checkSequence(f.begin(), f.end(), "Forces");
+}
+
+TEST_F(CmapTest, PlainKernelShiftForcesGiveWholeMoleculeVirial)
+{
+    const CmapOutput output = computeCmap(false, true);
+
+    /* The virial computed with the shift forces should equal
+     * the virial of the chain without periodic images.
+     */
+    rvec             shiftVectors[SHIFTS];
+    calc_shifts(box_, shiftVectors);
+    matrix           virial, virialWhole;
+    clear_mat(virial);
+    clear_mat(virialWhole);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        const rvec f = { output.f[4*a + XX], output.f[4*a + YY], output.f[4*a + ZZ] };
+        for (int d1 = 0; d1 < DIM; d1++)
+        {
+            for (int d2 = 0; d2 < DIM; d2++)
+            {
+                virial[d1][d2]      += x_[a][d1]*f[d2];
+                virialWhole[d1][d2] += xWhole_[a][d1]*f[d2];
+            }
+        }
+    }
+    for (int s = 0; s < SHIFTS; s++)
+    {
+        for (int d1 = 0; d1 < DIM; d1++)
+        {
+            for (int d2 = 0; d2 < DIM; d2++)
+            {
+                virial[d1][d2] += shiftVectors[s][d1]*output.fshift[s][d2];
+            }
+        }
+    }
+
+    const test::FloatingPointTolerance tolerance = test::absoluteTolerance(1e-3);
+    for (int d1 = 0; d1 < DIM; d1++)
+    {
+        for (int d2 = 0; d2 < DIM; d2++)
+        {
+            EXPECT_REAL_EQ_TOL(virialWhole[d1][d2], virial[d1][d2], tolerance);
+        }
+    }
+}
+
+#if GMX_SIMD_HAVE_REAL
+
+TEST_F(CmapTest, SimdKernelsMatchReference)
+{
+    const CmapOutput reference = computeCmap(false, true);
+    const CmapOutput output    = computeCmap(true, true);
+    const CmapOutput forces    = computeCmap(true, false);
+
+    const test::FloatingPointTolerance tolerance = test::relativeToleranceAsFloatingPoint(100.0, 1e-4);
+    EXPECT_REAL_EQ_TOL(reference.energy, output.energy, tolerance);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.f[4*a + d], output.f[4*a + d], tolerance);
+            EXPECT_REAL_EQ_TOL(reference.f[4*a + d], forces.f[4*a + d], tolerance);
+        }
+    }
+    for (int s = 0; s < SHIFTS; s++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.fshift[s][d], output.fshift[s][d], tolerance);
+        }
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
+}  // namespace
+
+}  // namespace gmx
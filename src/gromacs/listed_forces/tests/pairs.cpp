@@ -0,0 +1,280 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements test of the listed pair interaction kernels
+ *
+ * The analytical kernels for plain LJ and Coulomb pairs are compared
+ * with the general kernel that uses tabulated interactions.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include "gromacs/listed_forces/pairs.h"
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/tables/forcetable.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+//! Number of atoms used in these tests.
+constexpr int c_numAtoms = 7;
+
+//! Output of the pair kernels
+struct PairOutput
+{
+    //! Forces
+    std::vector<RVec> f = std::vector<RVec>(c_numAtoms, { 0, 0, 0 });
+    //! Shift forces
+    std::vector<RVec> fshift = std::vector<RVec>(SHIFTS, { 0, 0, 0 });
+    //! Energies per energy group pair
+    gmx_grppairener_t grppener;
+
+    //! Constructor
+    explicit PairOutput(int numEnergyGroups) : grppener(numEnergyGroups) {}
+};
+
+/*! \brief Test fixture for the pair kernels, parametrized on the pair
+ * interaction type and the number of energy groups */
+class PairsTest : public ::testing::TestWithParam<std::tuple<int, int> >
+{
+    protected:
+        //! Sets up a system with pairs, some of which cross the periodic boundaries
+        PairsTest() :
+            ic_(),
+            mdatoms_(),
+            ftype_(std::get<0>(GetParam())),
+            numEnergyGroups_(std::get<1>(GetParam()))
+        {
+            x_ = {
+                {  0.05,  0.10,  0.20 },
+                {  1.95,  0.15,  0.25 },
+                {  0.20,  0.30,  0.10 },
+                {  0.40,  1.90,  0.30 },
+                {  0.45,  0.05,  1.95 },
+                {  1.00,  1.00,  1.00 },
+                {  1.20,  1.10,  0.95 },
+                /* Padding for SIMD loads */
+                {  0.00,  0.00,  0.00 }
+            };
+            charge_ = { 0.5, -0.4, 0.3, -0.6, 0.2, 0.7, -0.7 };
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                energyGroup_.push_back(a % numEnergyGroups_);
+            }
+
+            clear_mat(box_);
+            box_[XX][XX] = 2.0;
+            box_[YY][YY] = 2.0;
+            box_[ZZ][ZZ] = 2.0;
+            set_pbc(&pbc_, epbcXYZ, box_);
+
+            iparams_.resize(2);
+            switch (ftype_)
+            {
+                case F_LJ14:
+                    iparams_[0].lj14.c6A  = iparams_[0].lj14.c6B  = 0.002;
+                    iparams_[0].lj14.c12A = iparams_[0].lj14.c12B = 3.0e-6;
+                    iparams_[1].lj14.c6A  = iparams_[1].lj14.c6B  = 0.004;
+                    iparams_[1].lj14.c12A = iparams_[1].lj14.c12B = 5.0e-6;
+                    break;
+                case F_LJC14_Q:
+                    iparams_[0].ljc14 = { 0.5, 0.4, -0.3, 0.002, 3.0e-6 };
+                    iparams_[1].ljc14 = { 0.8, -0.6, -0.2, 0.004, 5.0e-6 };
+                    break;
+                case F_LJC_PAIRS_NB:
+                    iparams_[0].ljcnb = { 0.4, -0.3, 0.002, 3.0e-6 };
+                    iparams_[1].ljcnb = { -0.6, -0.2, 0.004, 5.0e-6 };
+                    break;
+            }
+
+            /* Use more pairs than the SIMD width to test the padding.
+             * The last pair is beyond the table limit and should be skipped.
+             */
+            const int pairs[][2] = {
+                { 0, 1 }, { 0, 2 }, { 1, 2 }, { 0, 3 }, { 2, 4 },
+                { 0, 4 }, { 5, 6 }, { 3, 4 }, { 3, 5 }, { 0, 5 }
+            };
+            int       type = 0;
+            for (const auto &pair : pairs)
+            {
+                iatoms_.push_back(type);
+                iatoms_.push_back(pair[0]);
+                iatoms_.push_back(pair[1]);
+                type = 1 - type;
+            }
+
+            ic_.vdwtype   = evdwCUT;
+            ic_.eeltype   = eelCUT;
+            ic_.reppow    = 12;
+            ic_.epsilon_r = 1;
+            ic_.epsfac    = ONE_4PI_EPS0;
+            pairsTable_.reset(make_tables(nullptr, &ic_, nullptr, 1.5, GMX_MAKETABLES_14ONLY));
+
+            fr_.ic         = &ic_;
+            fr_.bMolPBC    = TRUE;
+            fr_.fudgeQQ    = 0.5;
+            fr_.pairsTable = pairsTable_.get();
+
+            mdatoms_.chargeA  = charge_.data();
+            mdatoms_.chargeB  = charge_.data();
+            mdatoms_.cENER    = energyGroup_.data();
+            mdatoms_.nenergrp = numEnergyGroups_;
+        }
+
+        //! Computes the pair interactions, with the general kernel when \p useGeneralKernel
+        PairOutput computePairs(bool useGeneralKernel, bool computeForcesOnly)
+        {
+            PairOutput output(numEnergyGroups_);
+
+            /* User tables always use the general kernel. The pair table
+             * has already been generated for plain LJ and Coulomb.
+             */
+            ic_.vdwtype = (useGeneralKernel ? evdwUSER : evdwCUT);
+            fr_.efep    = efepNO;
+
+            std::vector<real> f4Data(4*(c_numAtoms + 1), 0);
+            real              lambda[efptNR] = { 0 };
+            real              dvdl[efptNR]   = { 0 };
+            do_pairs(ftype_, static_cast<int>(iatoms_.size()), iatoms_.data(), iparams_.data(),
+                     as_rvec_array(x_.data()), reinterpret_cast<rvec4 *>(f4Data.data()),
+                     as_rvec_array(output.fshift.data()),
+                     &pbc_, nullptr, lambda, dvdl, &mdatoms_, &fr_,
+                     computeForcesOnly, false, &output.grppener, nullptr);
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    output.f[a][d] = f4Data[4*a + d];
+                }
+            }
+
+            return output;
+        }
+
+        //! Coordinates
+        std::vector<RVec>              x_;
+        //! Charges
+        std::vector<real>              charge_;
+        //! Energy group indices
+        std::vector<unsigned short>    energyGroup_;
+        //! Box
+        matrix                         box_;
+        //! PBC
+        t_pbc                          pbc_;
+        //! Interaction parameters
+        std::vector<t_iparams>         iparams_;
+        //! Pair list
+        std::vector<t_iatom>           iatoms_;
+        //! Interaction constants
+        interaction_const_t            ic_;
+        //! Pair interaction tables
+        std::unique_ptr<t_forcetable>  pairsTable_;
+        //! Force record
+        t_forcerec                     fr_;
+        //! Atom data
+        t_mdatoms                      mdatoms_;
+        //! The pair interaction type
+        int                            ftype_;
+        //! The number of energy groups
+        int                            numEnergyGroups_;
+};
+
+TEST_P(PairsTest, AnalyticalKernelMatchesTabulatedKernel)
+{
+    const PairOutput reference = computePairs(true, false);
+    const PairOutput output    = computePairs(false, false);
+    const PairOutput forces    = computePairs(false, true);
+
+    const test::FloatingPointTolerance tolerance = test::relativeToleranceAsFloatingPoint(100.0, 1e-4);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], tolerance);
+            EXPECT_REAL_EQ_TOL(output.f[a][d], forces.f[a][d], tolerance);
+        }
+    }
+    for (int s = 0; s < SHIFTS; s++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.fshift[s][d], output.fshift[s][d], tolerance);
+        }
+    }
+    const bool isNonbondedPair = (ftype_ == F_LJC_PAIRS_NB);
+    for (int term : { isNonbondedPair ? egCOULSR : egCOUL14, isNonbondedPair ? egLJSR : egLJ14 })
+    {
+        for (int i = 0; i < reference.grppener.nener; i++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.grppener.ener[term][i],
+                               output.grppener.ener[term][i], tolerance);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithEnergyGroups, PairsTest,
+                        ::testing::Combine(::testing::Values(F_LJ14, F_LJC14_Q, F_LJC_PAIRS_NB),
+                                           ::testing::Values(1, 2)));
+
+}  // namespace
+
+}  // namespace gmx
@@ -0,0 +1,256 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements test of the position restraint functions
+ *
+ * Checks that the threaded evaluation matches the serial one and that
+ * the energies for all foreign lambda values, which are computed in
+ * one pass, match separate evaluations.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include "gromacs/listed_forces/position_restraints.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+//! Number of restrained atoms, large enough to use multiple threads
+constexpr int c_numAtoms = 500;
+//! The foreign lambda values
+const std::vector<double> c_foreignLambdas = { 0.0, 0.3, 0.8, 1.0 };
+
+//! Output of the position restraint functions
+struct RestraintOutput
+{
+    //! Forces
+    std::vector<RVec> f = std::vector<RVec>(c_numAtoms, { 0, 0, 0 });
+    //! Virial
+    matrix            virial = { { 0 } };
+    //! Energies, dV/dlambda and energies at all lambda values
+    gmx_enerdata_t    enerd = gmx_enerdata_t(1, c_foreignLambdas.size());
+};
+
+//! Test fixture for position restraints
+class PositionRestraintsTest : public ::testing::Test
+{
+    protected:
+        //! Sets up restraints with and without perturbation
+        PositionRestraintsTest() :
+            idef_(),
+            fepvals_(),
+            nrnb_()
+        {
+            clear_mat(box_);
+            box_[XX][XX] = 3.0;
+            box_[YY][YY] = 3.5;
+            box_[ZZ][ZZ] = 2.5;
+            set_pbc(&pbc_, epbcXYZ, box_);
+
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                x_.push_back({ 0.006f*a, 0.0075f*((a*7) % c_numAtoms), 0.005f*((a*13) % c_numAtoms) });
+
+                /* Every third atom has a perturbed restraint */
+                t_iparams ip;
+                for (int d = 0; d < DIM; d++)
+                {
+                    ip.posres.pos0A[d] = x_[a][d] + 0.01f*((a + d) % 5) - 0.02f;
+                    ip.posres.fcA[d]   = 1000 + 100*d;
+                    ip.posres.pos0B[d] = ip.posres.pos0A[d];
+                    ip.posres.fcB[d]   = ip.posres.fcA[d];
+                }
+                if (a % 3 == 0)
+                {
+                    ip.posres.pos0B[XX] += 0.05;
+                    ip.posres.fcB[ZZ]    = 500;
+                }
+                posresParams_.push_back(ip);
+                posresIatoms_.push_back(posresParams_.size() - 1);
+                posresIatoms_.push_back(a);
+
+                ip.fbposres.pos0[XX] = x_[a][XX] + 0.04f*((a % 7) - 3);
+                ip.fbposres.pos0[YY] = x_[a][YY] - 0.03f*((a % 5) - 2);
+                ip.fbposres.pos0[ZZ] = x_[a][ZZ] + 0.02f*((a % 3) - 1);
+                ip.fbposres.r        = (a % 4 == 0 ? -0.05 : 0.03);
+                ip.fbposres.k        = 800;
+                ip.fbposres.geom     = efbposresSPHERE + a % (efbposresZ - efbposresSPHERE + 1);
+                fbposresParams_.push_back(ip);
+                fbposresIatoms_.push_back(fbposresParams_.size() - 1);
+                fbposresIatoms_.push_back(a);
+            }
+
+            idef_.il[F_POSRES].nr       = posresIatoms_.size();
+            idef_.il[F_POSRES].iatoms   = posresIatoms_.data();
+            idef_.iparams_posres        = posresParams_.data();
+            idef_.il[F_FBPOSRES].nr     = fbposresIatoms_.size();
+            idef_.il[F_FBPOSRES].iatoms = fbposresIatoms_.data();
+            idef_.iparams_fbposres      = fbposresParams_.data();
+
+            fr_.ePBC       = epbcXYZ;
+            fr_.rc_scaling = erscNO;
+
+            allLambdas_.resize(efptNR);
+            allLambdas_[efptRESTRAINT] = c_foreignLambdas;
+            for (int i = 0; i < efptNR; i++)
+            {
+                allLambdaPointers_.push_back(allLambdas_[efptRESTRAINT].data());
+            }
+            fepvals_.n_lambda   = c_foreignLambdas.size();
+            fepvals_.all_lambda = allLambdaPointers_.data();
+        }
+
+        //! Computes the restraints using \p numThreads threads
+        RestraintOutput computeRestraints(int numThreads, real lambda)
+        {
+            const int numThreadsOrig = gmx_omp_nthreads_get(emntBonded);
+            gmx_omp_nthreads_set(emntBonded, numThreads);
+
+            RestraintOutput      output;
+            ForceWithVirial      forceWithVirial(output.f, true);
+            real                 lambdas[efptNR] = { 0 };
+            lambdas[efptRESTRAINT] = lambda;
+
+            posres_wrapper(&nrnb_, &idef_, &pbc_, as_rvec_array(x_.data()), &output.enerd,
+                           lambdas, &fr_, &forceWithVirial);
+            fbposres_wrapper(&nrnb_, &idef_, &pbc_, as_rvec_array(x_.data()), &output.enerd,
+                             &fr_, &forceWithVirial);
+            posres_wrapper_lambda(nullptr, &fepvals_, &idef_, &pbc_, as_rvec_array(x_.data()),
+                                  &output.enerd, lambdas, &fr_);
+            copy_mat(forceWithVirial.getVirial(), output.virial);
+
+            gmx_omp_nthreads_set(emntBonded, numThreadsOrig);
+
+            return output;
+        }
+
+        //! Coordinates
+        std::vector<RVec>                 x_;
+        //! Box
+        matrix                            box_;
+        //! PBC
+        t_pbc                             pbc_;
+        //! Position restraint parameters
+        std::vector<t_iparams>            posresParams_;
+        //! Position restraint list
+        std::vector<t_iatom>              posresIatoms_;
+        //! Flat-bottomed position restraint parameters
+        std::vector<t_iparams>            fbposresParams_;
+        //! Flat-bottomed position restraint list
+        std::vector<t_iatom>              fbposresIatoms_;
+        //! Interaction definitions
+        t_idef                            idef_;
+        //! Force record
+        t_forcerec                        fr_;
+        //! Lambda values per component
+        std::vector < std::vector < double>> allLambdas_;
+        //! Pointers to the lambda values per component
+        std::vector<double *>             allLambdaPointers_;
+        //! Free-energy parameters
+        t_lambda                          fepvals_;
+        //! Flop counters
+        t_nrnb                            nrnb_;
+};
+
+TEST_F(PositionRestraintsTest, ThreadedMatchesSerial)
+{
+    const RestraintOutput reference = computeRestraints(1, 0.4);
+    const RestraintOutput output    = computeRestraints(3, 0.4);
+
+    const test::FloatingPointTolerance tolerance = test::relativeToleranceAsFloatingPoint(1000.0, 1e-5);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], tolerance);
+        }
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.virial[d][d], output.virial[d][d], tolerance);
+    }
+    EXPECT_REAL_EQ_TOL(reference.enerd.term[F_POSRES], output.enerd.term[F_POSRES], tolerance);
+    EXPECT_REAL_EQ_TOL(reference.enerd.term[F_FBPOSRES], output.enerd.term[F_FBPOSRES], tolerance);
+    EXPECT_REAL_EQ_TOL(reference.enerd.dvdl_nonlin[efptRESTRAINT],
+                       output.enerd.dvdl_nonlin[efptRESTRAINT], tolerance);
+    for (size_t i = 0; i < reference.enerd.enerpart_lambda.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.enerd.enerpart_lambda[i],
+                           output.enerd.enerpart_lambda[i], tolerance);
+    }
+}
+
+TEST_F(PositionRestraintsTest, ForeignLambdaEnergiesMatchSeparateEvaluations)
+{
+    const real            lambda = 0.4;
+    const RestraintOutput output = computeRestraints(3, lambda);
+
+    const test::FloatingPointTolerance tolerance = test::relativeToleranceAsFloatingPoint(1000.0, 1e-5);
+    for (size_t i = 0; i < output.enerd.enerpart_lambda.size(); i++)
+    {
+        const real            lambdaI   = (i == 0 ? lambda : c_foreignLambdas[i - 1]);
+        const RestraintOutput reference = computeRestraints(1, lambdaI);
+        EXPECT_REAL_EQ_TOL(reference.enerd.term[F_POSRES], output.enerd.enerpart_lambda[i], tolerance);
+    }
+}
+
+}  // namespace
+
+}  // namespace gmx
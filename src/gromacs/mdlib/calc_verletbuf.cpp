@@ -53,6 +53,7 @@
 #include "gromacs/topology/block.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/strconvert.h"
@@ -633,7 +634,8 @@ static real energyDrift(gmx::ArrayRef<const VerletbufAtomtype> att,
                         const pot_derivatives_t *ljRep,
                         const pot_derivatives_t *elec,
                         real rlj, real rcoulomb,
-                        real rlist, real boxvol)
+                        real rlist, real boxvol,
+                        int numThreads)
 {
     double drift_tot = 0;
 
@@ -643,70 +645,91 @@ static real energyDrift(gmx::ArrayRef<const VerletbufAtomtype> att,
         return drift_tot;
     }
 
+    // Get the thermal displacement variances for all atom types
+    std::vector<real> s2_2d(att.size());
+    std::vector<real> s2_3d(att.size());
+    for (int i = 0; i < att.ssize(); i++)
+    {
+        get_atom_sigma2(kT_fac, &att[i].prop, &s2_2d[i], &s2_3d[i]);
+    }
+
     // Here add up the contribution of all atom pairs in the system to
     // (estimated) energy drift by looping over all atom type pairs.
+    // The contributions are summed in a fixed order afterwards,
+    // so the result does not depend on the number of threads.
+    std::vector<double> drift_i(att.size());
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
     for (int i = 0; i < att.ssize(); i++)
     {
-        // Get the thermal displacement variance for the i-atom type
-        const atom_nonbonded_kinetic_prop_t *prop_i = &att[i].prop;
-        real                                 s2i_2d, s2i_3d;
-        get_atom_sigma2(kT_fac, prop_i, &s2i_2d, &s2i_3d);
-
-        for (int j = i; j < att.ssize(); j++)
+        try
         {
-            // Get the thermal displacement variance for the j-atom type
-            const atom_nonbonded_kinetic_prop_t *prop_j = &att[j].prop;
-            real                                 s2j_2d, s2j_3d;
-            get_atom_sigma2(kT_fac, prop_j, &s2j_2d, &s2j_3d);
-
-            /* Add up the up to four independent variances */
-            real s2 = s2i_2d + s2i_3d + s2j_2d + s2j_3d;
-
-            // Set -V', V'' and -V''' at the cut-off for LJ */
-            real              c6  = ffp->iparams[prop_i->type*ffp->atnr + prop_j->type].lj.c6;
-            real              c12 = ffp->iparams[prop_i->type*ffp->atnr + prop_j->type].lj.c12;
-            pot_derivatives_t lj;
-            lj.md1 = c6*ljDisp->md1 + c12*ljRep->md1;
-            lj.d2  = c6*ljDisp->d2  + c12*ljRep->d2;
-            lj.md3 = c6*ljDisp->md3 + c12*ljRep->md3;
-
-            real pot_lj = energyDriftAtomPair(prop_i->bConstr, prop_j->bConstr,
-                                              s2, s2i_2d, s2j_2d,
-                                              rlist - rlj,
-                                              &lj);
-
-            // Set -V' and V'' at the cut-off for Coulomb
-            pot_derivatives_t elec_qq;
-            elec_qq.md1 = elec->md1*prop_i->q*prop_j->q;
-            elec_qq.d2  = elec->d2 *prop_i->q*prop_j->q;
-            elec_qq.md3 = 0;
-
-            real pot_q  = energyDriftAtomPair(prop_i->bConstr, prop_j->bConstr,
-                                              s2, s2i_2d, s2j_2d,
-                                              rlist - rcoulomb,
-                                              &elec_qq);
-
-            // Note that attractive and repulsive potentials for individual
-            // pairs can partially cancel.
-            real pot = pot_lj + pot_q;
-
-            /* Multiply by the number of atom pairs */
-            if (j == i)
-            {
-                pot *= static_cast<double>(att[i].n)*(att[i].n - 1)/2;
-            }
-            else
+            const atom_nonbonded_kinetic_prop_t *prop_i = &att[i].prop;
+            const real                           s2i_2d = s2_2d[i];
+            const real                           s2i_3d = s2_3d[i];
+
+            double                               drift = 0;
+            for (int j = i; j < att.ssize(); j++)
             {
-                pot *= static_cast<double>(att[i].n)*att[j].n;
-            }
-            /* We need the line density to get the energy drift of the system.
-             * The effective average r^2 is close to (rlist+sigma)^2.
-             */
-            pot *= 4*M_PI*gmx::square(rlist + std::sqrt(s2))/boxvol;
+                const atom_nonbonded_kinetic_prop_t *prop_j = &att[j].prop;
+                const real                           s2j_2d = s2_2d[j];
+                const real                           s2j_3d = s2_3d[j];
+
+                /* Add up the up to four independent variances */
+                real s2 = s2i_2d + s2i_3d + s2j_2d + s2j_3d;
+
+                // Set -V', V'' and -V''' at the cut-off for LJ */
+                real              c6  = ffp->iparams[prop_i->type*ffp->atnr + prop_j->type].lj.c6;
+                real              c12 = ffp->iparams[prop_i->type*ffp->atnr + prop_j->type].lj.c12;
+                pot_derivatives_t lj;
+                lj.md1 = c6*ljDisp->md1 + c12*ljRep->md1;
+                lj.d2  = c6*ljDisp->d2  + c12*ljRep->d2;
+                lj.md3 = c6*ljDisp->md3 + c12*ljRep->md3;
+
+                real pot_lj = energyDriftAtomPair(prop_i->bConstr, prop_j->bConstr,
+                                                  s2, s2i_2d, s2j_2d,
+                                                  rlist - rlj,
+                                                  &lj);
+
+                // Set -V' and V'' at the cut-off for Coulomb
+                pot_derivatives_t elec_qq;
+                elec_qq.md1 = elec->md1*prop_i->q*prop_j->q;
+                elec_qq.d2  = elec->d2 *prop_i->q*prop_j->q;
+                elec_qq.md3 = 0;
+
+                real pot_q  = energyDriftAtomPair(prop_i->bConstr, prop_j->bConstr,
+                                                  s2, s2i_2d, s2j_2d,
+                                                  rlist - rcoulomb,
+                                                  &elec_qq);
+
+                // Note that attractive and repulsive potentials for individual
+                // pairs can partially cancel.
+                real pot = pot_lj + pot_q;
+
+                /* Multiply by the number of atom pairs */
+                if (j == i)
+                {
+                    pot *= static_cast<double>(att[i].n)*(att[i].n - 1)/2;
+                }
+                else
+                {
+                    pot *= static_cast<double>(att[i].n)*att[j].n;
+                }
+                /* We need the line density to get the energy drift of the system.
+                 * The effective average r^2 is close to (rlist+sigma)^2.
+                 */
+                pot *= 4*M_PI*gmx::square(rlist + std::sqrt(s2))/boxvol;
 
-            /* Add the unsigned drift to avoid cancellation of errors */
-            drift_tot += std::abs(pot);
+                /* Add the unsigned drift to avoid cancellation of errors */
+                drift += std::abs(pot);
+            }
+            drift_i[i] = drift;
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    for (double drift : drift_i)
+    {
+        drift_tot += drift;
     }
 
     return drift_tot;
@@ -852,7 +875,8 @@ calcVerletBufferSize(const gmx_mtop_t         &mtop,
                      const int                 nstlist,
                      const int                 listLifetime,
                      real                      referenceTemperature,
-                     const VerletbufListSetup &listSetup)
+                     const VerletbufListSetup &listSetup,
+                     const int                 numThreads)
 {
     double                resolution;
     char                 *env;
@@ -1075,7 +1099,7 @@ calcVerletBufferSize(const gmx_mtop_t         &mtop,
                             kT_fac,
                             &ljDisp, &ljRep, &elec,
                             ir.rvdw, ir.rcoulomb,
-                            rl, boxVolume);
+                            rl, boxVolume, numThreads);
 
         /* Correct for the fact that we are using a Ni x Nj particle pair list
          * and not a 1 x 1 particle pair list. This reduces the drift.
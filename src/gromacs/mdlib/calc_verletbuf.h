@@ -112,6 +112,7 @@ VerletbufListSetup verletbufGetSafeListSetup(ListSetupType listType);
  * \param[in] listLifetime  The lifetime of the pair-list, usually nstlist-1, but could be different for dynamic pruning
  * \param[in] referenceTemperature  The reference temperature for the ensemble
  * \param[in] listSetup     The pair-list setup
+ * \param[in] numThreads    The number of OpenMP threads to use for the energy drift estimate
  * \returns The computed pair-list radius including buffer
  */
 real
@@ -121,7 +122,8 @@ calcVerletBufferSize(const gmx_mtop_t         &mtop,
                      int                       nstlist,
                      int                       listLifetime,
                      real                      referenceTemperature,
-                     const VerletbufListSetup &listSetup);
+                     const VerletbufListSetup &listSetup,
+                     int                       numThreads);
 
 /* Convenience type */
 using PartitioningPerMoltype = gmx::ArrayRef<const gmx::RangePartitioning>;
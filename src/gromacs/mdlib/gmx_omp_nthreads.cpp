@@ -42,8 +42,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 
 #include "gromacs/gmxlib/network.h"
+#include "gromacs/mdlib/threadteam.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
@@ -94,6 +96,12 @@ static const char *mod_name[emntNR] =
  * */
 static omp_module_nthreads_t modth = { 0, 0, {0, 0, 0, 0, 0, 0, 0, 0, 0}, FALSE};
 
+/** The persistent thread team of this rank, nullptr when not in use.
+ *
+ *  With thread-MPI each rank is a thread, so the team is thread local.
+ * */
+static thread_local std::unique_ptr<gmx::ThreadTeam> threadTeam;
+
 
 /** Determine the number of threads for module \p mod.
  *
@@ -492,6 +500,22 @@ void gmx_omp_nthreads_init(const gmx::MDLogger &mdlog, t_commrec *cr,
 #endif
 
     reportOpenmpSettings(mdlog, cr, bOMP, bFullOmpSupport, bSepPME);
+
+    /* The thread team is only used for simple loops on PP ranks */
+    if (getenv("GMX_USE_THREAD_TEAM") != nullptr &&
+        bFullOmpSupport && thisRankHasDuty(cr, DUTY_PP) && modth.gnth > 1)
+    {
+        threadTeam = std::make_unique<gmx::ThreadTeam>(modth.gnth);
+
+        GMX_LOG(mdlog.info).asParagraph().appendTextFormatted(
+                "Using a persistent team of %d threads instead of OpenMP for simple parallel loops",
+                modth.gnth);
+    }
+}
+
+gmx::ThreadTeam *gmx_omp_nthreads_get_thread_team()
+{
+    return threadTeam.get();
 }
 
 int gmx_omp_nthreads_get(int mod)
@@ -45,6 +45,7 @@ struct t_commrec;
 namespace gmx
 {
 class MDLogger;
+class ThreadTeam;
 }
 
 /** Enum values corresponding to multithreaded algorithmic modules. */
@@ -75,6 +76,13 @@ void gmx_omp_nthreads_init(const gmx::MDLogger &fplog, t_commrec *cr,
  * Returns the number of threads to be used in the given module \p mod. */
 int gmx_omp_nthreads_get(int mod);
 
+/*! \brief
+ * Returns the persistent thread team of this rank, nullptr when not in use.
+ *
+ * The team is created by gmx_omp_nthreads_init() when the environment
+ * variable GMX_USE_THREAD_TEAM is set. */
+gmx::ThreadTeam *gmx_omp_nthreads_get_thread_team();
+
 /*! \brief
  * Returns the number of threads to be used in the given module \p mod for simple rvec operations.
  *
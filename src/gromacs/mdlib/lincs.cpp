@@ -90,6 +90,14 @@ using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
 namespace gmx
 {
 
+/*! \brief The maximum size of clusters of coupled constraints for independent tasks
+ *
+ * With more than two sequential constraints we can still use independent
+ * LINCS tasks, by assigning whole clusters of connected constraints to
+ * a single task. This limit keeps the load imbalance between the tasks low.
+ */
+static constexpr int c_maxClusterSizeForIndependentTasks = 64;
+
 //! Indices of the two atoms involved in a single constraint
 struct AtomPair
 {
@@ -1442,6 +1450,61 @@ static bool more_than_two_sequential_constraints(const InteractionLists &ilist,
     return bMoreThanTwoSequentialConstraints;
 }
 
+/*! \brief Returns the number of constraints in the largest cluster of connected constraints
+ *
+ * \param[in] ilist   The interaction lists of a molecule type
+ * \param[in] at2con  The atom to constraint list of the molecule type
+ */
+static int maxConstraintClusterSize(const InteractionLists &ilist,
+                                    const t_blocka         &at2con)
+{
+    const int                ncon_tot = (ilist[F_CONSTR].size() + ilist[F_CONSTRNC].size())/3;
+
+    gmx::ArrayRef<const int> ia1 = ilist[F_CONSTR].iatoms;
+    gmx::ArrayRef<const int> ia2 = ilist[F_CONSTRNC].iatoms;
+
+    std::vector<bool>        isVisited(ncon_tot, false);
+    std::vector<int>         stack;
+    int                      maxClusterSize = 0;
+    for (int c0 = 0; c0 < ncon_tot; c0++)
+    {
+        if (isVisited[c0])
+        {
+            continue;
+        }
+
+        /* Depth first search over all constraints connected to c0 */
+        int clusterSize = 0;
+        isVisited[c0]   = true;
+        stack.push_back(c0);
+        while (!stack.empty())
+        {
+            const int  c   = stack.back();
+            stack.pop_back();
+            clusterSize++;
+
+            const int *iap = constr_iatomptr(ia1, ia2, c);
+            for (int end = 1; end <= 2; end++)
+            {
+                const int a = iap[end];
+                for (int n = at2con.index[a]; n < at2con.index[a + 1]; n++)
+                {
+                    const int cc = at2con.a[n];
+                    if (!isVisited[cc])
+                    {
+                        isVisited[cc] = true;
+                        stack.push_back(cc);
+                    }
+                }
+            }
+        }
+
+        maxClusterSize = std::max(maxClusterSize, clusterSize);
+    }
+
+    return maxClusterSize;
+}
+
 Lincs *init_lincs(FILE *fplog, const gmx_mtop_t &mtop,
                   int nflexcon_global, ArrayRef<const t_blocka> at2con,
                   bool bPLINCS, int nIter, int nProjOrder)
@@ -1478,6 +1541,7 @@ Lincs *init_lincs(FILE *fplog, const gmx_mtop_t &mtop,
 
     li->ncg_triangle = 0;
     bMoreThanTwoSeq  = FALSE;
+    int maxClusterSize = 0;
     for (const gmx_molblock_t &molb : mtop.molblock)
     {
         const gmx_moltype_t &molt = mtop.moltype[molb.type];
@@ -1491,6 +1555,9 @@ Lincs *init_lincs(FILE *fplog, const gmx_mtop_t &mtop,
         {
             bMoreThanTwoSeq = TRUE;
         }
+
+        maxClusterSize = std::max(maxClusterSize,
+                                  maxConstraintClusterSize(molt.ilist, at2con[molb.type]));
     }
 
     /* Check if we need to communicate not only before LINCS,
@@ -1511,11 +1578,24 @@ Lincs *init_lincs(FILE *fplog, const gmx_mtop_t &mtop,
     /* LINCS can run on any number of threads.
      * Currently the number is fixed for the whole simulation,
      * but it could be set in set_lincs().
-     * The current constraint to task assignment code can create independent
-     * tasks only when not more than two constraints are connected sequentially.
+     * The constraint to task assignment code creates independent tasks
+     * by assigning whole clusters of connected constraints to a task.
+     * This is always the case when not more than two constraints are
+     * connected sequentially. For coupled clusters, e.g. molecules with
+     * angle constraints, we only do this when the clusters are small,
+     * so the load can be balanced over the tasks. With independent tasks
+     * the matrix expansion and the atom update need no barriers and
+     * there are no constraints that need to be updated serially.
      */
     li->ntask    = gmx_omp_nthreads_get(emntLINCS);
-    li->bTaskDep = (li->ntask > 1 && bMoreThanTwoSeq);
+    li->bTaskDep = (li->ntask > 1 && bMoreThanTwoSeq &&
+                    maxClusterSize > c_maxClusterSizeForIndependentTasks);
+    if (fplog && li->ntask > 1 && bMoreThanTwoSeq && !li->bTaskDep)
+    {
+        fprintf(fplog, "The constraints form clusters of at most %d constraints,\n"
+                "will assign whole clusters to independent LINCS tasks\n",
+                maxClusterSize);
+    }
     if (debug)
     {
         fprintf(debug, "LINCS: using %d threads, tasks are %sdependent\n",
@@ -1696,30 +1776,33 @@ static void assign_constraint(Lincs *li,
 }
 
 /*! \brief Check if constraint with topology index constraint_index is connected
- * to other constraints, and if so add those connected constraints to our task. */
+ * to other constraints, and if so add all constraints in the cluster of
+ * connected constraints to our task.
+ *
+ * \p atomQueue is used as temporary storage.
+ */
 static void check_assign_connected(Lincs *li,
                                    const t_iatom *iatom,
                                    const t_idef &idef,
                                    bool bDynamics,
                                    int a1, int a2,
-                                   const t_blocka *at2con)
+                                   const t_blocka *at2con,
+                                   std::vector<int> *atomQueue)
 {
-    /* Currently this function only supports constraint groups
-     * in which all constraints share at least one atom
-     * (e.g. H-bond constraints).
-     * Check both ends of the current constraint for
-     * connected constraints. We need to assign those
-     * to the same task.
+    /* Check both ends of the current constraint for connected
+     * constraints. We need to assign those to the same task.
+     * We continue with the other ends of the newly assigned constraints,
+     * which only has an effect with more than two sequential constraints.
      */
-    int end;
+    atomQueue->clear();
+    atomQueue->push_back(a1);
+    atomQueue->push_back(a2);
 
-    for (end = 0; end < 2; end++)
+    for (size_t i = 0; i < atomQueue->size(); i++)
     {
-        int a, k;
+        const int a = (*atomQueue)[i];
 
-        a = (end == 0 ? a1 : a2);
-
-        for (k = at2con->index[a]; k < at2con->index[a + 1]; k++)
+        for (int k = at2con->index[a]; k < at2con->index[a + 1]; k++)
         {
             int cc;
 
@@ -1736,7 +1819,12 @@ static void check_assign_connected(Lincs *li,
 
                 if (bDynamics || lenA != 0 || lenB != 0)
                 {
-                    assign_constraint(li, cc, iatom[3*cc + 1], iatom[3*cc + 2], lenA, lenB, at2con);
+                    const int ca1 = iatom[3*cc + 1];
+                    const int ca2 = iatom[3*cc + 2];
+
+                    assign_constraint(li, cc, ca1, ca2, lenA, lenB, at2con);
+
+                    atomQueue->push_back(ca1 == a ? ca2 : ca1);
                 }
             }
         }
@@ -2000,6 +2088,9 @@ void set_lincs(const t_idef         &idef,
         li->con_index[con] = -1;
     }
 
+    /* Temporary storage for assigning clusters of connected constraints */
+    std::vector<int> atomQueue;
+
     int con = 0;
     for (int th = 0; th < li->ntask; th++)
     {
@@ -2053,7 +2144,7 @@ void set_lincs(const t_idef         &idef,
                          * need to assign connected constraints to our task.
                          */
                         check_assign_connected(li, iatom, idef, bDynamics,
-                                               a1, a2, &at2con);
+                                               a1, a2, &at2con, &atomQueue);
                     }
                     if (li->ntask > 1 && li->ncg_triangle > 0)
                     {
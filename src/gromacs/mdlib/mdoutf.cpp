@@ -77,6 +77,8 @@ struct gmx_mdoutf {
     int                            natoms_global;
     int                            natoms_x_compressed;
     SimulationGroups              *groups; /* for compressed position writing */
+    int                           *x_compressed_index; /* global atom indices in the compressed output, only set for a subset */
+    rvec                          *x_compressed;       /* buffer for the compressed output subset */
     gmx_wallcycle_t                wcycle;
     rvec                          *f_global;
     gmx::IMDOutputProvider        *outputProvider;
@@ -215,6 +217,21 @@ gmx_mdoutf_t init_mdoutf(FILE *fplog, int nfile, const t_filenm fnm[],
                 of->natoms_x_compressed++;
             }
         }
+        if (of->natoms_x_compressed != of->natoms_global)
+        {
+            /* Store the subset once, so we do not need to look up
+               the group of every atom at every output step. */
+            int j = 0;
+            snew(of->x_compressed_index, of->natoms_x_compressed);
+            snew(of->x_compressed, of->natoms_x_compressed);
+            for (i = 0; (i < top_global->natoms); i++)
+            {
+                if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                {
+                    of->x_compressed_index[j++] = i;
+                }
+            }
+        }
 
         if (ir->nstfout && DOMAINDECOMP(cr))
         {
@@ -356,16 +373,11 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, const t_commrec *cr,
                 /* We are writing the positions of only a subset of
                    the atoms to the compressed output, so we have to
                    make a copy of the subset of coordinates. */
-                int i, j;
-
-                snew(xxtc, of->natoms_x_compressed);
+                xxtc = of->x_compressed;
                 auto x = makeArrayRef(state_global->x);
-                for (i = 0, j = 0; (i < of->natoms_global); i++)
+                for (int j = 0; j < of->natoms_x_compressed; j++)
                 {
-                    if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
-                    {
-                        copy_rvec(x[i], xxtc[j++]);
-                    }
+                    copy_rvec(x[of->x_compressed_index[j]], xxtc[j]);
                 }
             }
             if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t,
@@ -386,10 +398,6 @@ void mdoutf_write_to_trajectory_files(FILE *fplog, const t_commrec *cr,
                            xxtc,
                            nullptr,
                            nullptr);
-            if (of->natoms_x_compressed != of->natoms_global)
-            {
-                sfree(xxtc);
-            }
         }
         if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)) )
         {
@@ -466,6 +474,8 @@ void done_mdoutf(gmx_mdoutf_t of)
     {
         sfree(of->f_global);
     }
+    sfree(of->x_compressed_index);
+    sfree(of->x_compressed);
 
     gmx_tng_close(&of->tng);
     gmx_tng_close(&of->tng_low_prec);
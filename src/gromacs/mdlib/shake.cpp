@@ -49,19 +49,24 @@
 #include <cmath>
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/constr.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/splitter.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/topology/invblock.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 namespace gmx
 {
@@ -80,6 +85,9 @@ struct shakedata
     int   nblocks;        /* The number of SHAKE blocks         */
     int  *sblock;         /* The SHAKE blocks                   */
     int   sblock_nalloc;  /* The allocation size of sblock      */
+    /* Whether the blocks share no atoms, so different threads
+     * can constrain them concurrently */
+    bool  blocksAreIndependent;
     /*! \brief Scaled Lagrange multiplier for each constraint.
      *
      * Value is -2 * eta from p. 336 of the paper, divided by the
@@ -285,6 +293,7 @@ make_shake_sblock_serial(shakedata *shaked,
     }
     sfree(sb);
     sfree(inv_sblock);
+    shaked->blocksAreIndependent = true;
     resizeLagrangianData(shaked, ncons);
 }
 
@@ -320,6 +329,8 @@ make_shake_sblock_dd(shakedata          *shaked,
         iatom += 3;
     }
     shaked->sblock[shaked->nblocks] = 3*ncons;
+    /* These blocks are not guaranteed to share no atoms */
+    shaked->blocksAreIndependent = false;
     resizeLagrangianData(shaked, ncons);
 }
 
@@ -529,8 +540,14 @@ crattle(const int iatom[], int ncon, int *nnit, int maxnit,
     *nerror = error;
 }
 
-//! Applies SHAKE
-static int vec_shakef(FILE *fplog, shakedata *shaked,
+/*! \brief Applies SHAKE to the block of \p ncon constraints starting at constraint \p conOffset
+ *
+ * Only uses the SHAKE work arrays for this block, so different blocks
+ * can be constrained concurrently. Returns the number of iterations,
+ * or 0 on failure, in which case \p errorMessage is set. The caller
+ * prints the message, so messages of concurrent calls do not mix.
+ */
+static int vec_shakef(std::string *errorMessage, const shakedata *shaked, int conOffset,
                       const real invmass[], int ncon,
                       t_iparams ip[], t_iatom *iatom,
                       real tol, const rvec x[], rvec prime[], real omega,
@@ -548,18 +565,10 @@ static int vec_shakef(FILE *fplog, shakedata *shaked,
     int      error = 0;
     real     constraint_distance;
 
-    if (ncon > shaked->nalloc)
-    {
-        shaked->nalloc = over_alloc_dd(ncon);
-        srenew(shaked->rij, shaked->nalloc);
-        srenew(shaked->half_of_reduced_mass, shaked->nalloc);
-        srenew(shaked->distance_squared_tolerance, shaked->nalloc);
-        srenew(shaked->constraint_distance_squared, shaked->nalloc);
-    }
-    rij                          = shaked->rij;
-    half_of_reduced_mass         = shaked->half_of_reduced_mass;
-    distance_squared_tolerance   = shaked->distance_squared_tolerance;
-    constraint_distance_squared  = shaked->constraint_distance_squared;
+    rij                          = shaked->rij + conOffset;
+    half_of_reduced_mass         = shaked->half_of_reduced_mass + conOffset;
+    distance_squared_tolerance   = shaked->distance_squared_tolerance + conOffset;
+    constraint_distance_squared  = shaked->constraint_distance_squared + conOffset;
 
     L1   = 1.0-lambda;
     ia   = iatom;
@@ -600,25 +609,15 @@ static int vec_shakef(FILE *fplog, shakedata *shaked,
 
     if (nit >= maxnit)
     {
-        if (fplog)
-        {
-            fprintf(fplog, "Shake did not converge in %d steps\n", maxnit);
-        }
-        fprintf(stderr, "Shake did not converge in %d steps\n", maxnit);
-        nit = 0;
+        *errorMessage = gmx::formatString("Shake did not converge in %d steps\n", maxnit);
+        nit           = 0;
     }
     else if (error != 0)
     {
-        if (fplog)
-        {
-            fprintf(fplog, "Inner product between old and new vector <= 0.0!\n"
-                    "constraint #%d atoms %d and %d\n",
-                    error-1, iatom[3*(error-1)+1]+1, iatom[3*(error-1)+2]+1);
-        }
-        fprintf(stderr, "Inner product between old and new vector <= 0.0!\n"
-                "constraint #%d atoms %d and %d\n",
-                error-1, iatom[3*(error-1)+1]+1, iatom[3*(error-1)+2]+1);
-        nit = 0;
+        *errorMessage = gmx::formatString("Inner product between old and new vector <= 0.0!\n"
+                                          "constraint #%d atoms %d and %d\n",
+                                          error-1, iatom[3*(error-1)+1]+1, iatom[3*(error-1)+2]+1);
+        nit           = 0;
     }
 
     /* Constraint virial and correct the Lagrange multipliers for the length */
@@ -724,6 +723,34 @@ static void check_cons(FILE *log, int nc, const rvec x[], rvec prime[], rvec v[]
     }
 }
 
+/*! \brief Returns the first SHAKE block for \p thread out of \p numThreads
+ *
+ * The constraints are divided evenly over the threads,
+ * with the boundaries rounded up to the next block boundary.
+ */
+static int shakeBlockStart(const shakedata &shaked, int ncon, int numThreads, int thread)
+{
+    const int *sblockBegin = shaked.sblock;
+    const int *sblockEnd   = shaked.sblock + shaked.nblocks;
+
+    return std::lower_bound(sblockBegin, sblockEnd, 3*((ncon*thread)/numThreads)) - sblockBegin;
+}
+
+//! Output of SHAKE for the blocks assigned to one thread
+struct ShakeThreadOutput
+{
+    //! The number of iterations summed over the constraints
+    int         numIterations  = 0;
+    //! The number of constraints
+    int         numConstraints = 0;
+    //! The first block that failed to converge, -1 when all converged
+    int         failedBlock    = -1;
+    //! The error message for the failed block
+    std::string errorMessage;
+    //! The constraint virial contribution
+    tensor      virial         = { { 0 } };
+};
+
 //! Applies SHAKE.
 static bool
 bshakef(FILE *log, shakedata *shaked,
@@ -733,47 +760,94 @@ bshakef(FILE *log, shakedata *shaked,
         real invdt, rvec *v, bool bCalcVir, tensor vir_r_m_dr,
         bool bDumpOnError, ConstraintVariable econq)
 {
-    t_iatom *iatoms;
-    real    *lam, dt_2, dvdl;
-    int      i, n0, ncon, blen, type, ll;
-    int      tnit = 0, trij = 0;
+    real    dt_2, dvdl;
+    int     ncon, type, ll;
+    int     tnit = 0, trij = 0;
 
     ncon = idef.il[F_CONSTR].nr/3;
 
+    if (ncon > shaked->nalloc)
+    {
+        shaked->nalloc = over_alloc_dd(ncon);
+        srenew(shaked->rij, shaked->nalloc);
+        srenew(shaked->half_of_reduced_mass, shaked->nalloc);
+        srenew(shaked->distance_squared_tolerance, shaked->nalloc);
+        srenew(shaked->constraint_distance_squared, shaked->nalloc);
+    }
+
     for (ll = 0; ll < ncon; ll++)
     {
         shaked->scaled_lagrange_multiplier[ll] = 0;
     }
 
-    // TODO Rewrite this block so that it is obvious that i, iatoms
-    // and lam are all iteration variables. Is this easier if the
-    // sblock data structure is organized differently?
-    iatoms = &(idef.il[F_CONSTR].iatoms[shaked->sblock[0]]);
-    lam    = shaked->scaled_lagrange_multiplier;
-    for (i = 0; (i < shaked->nblocks); )
-    {
-        blen  = (shaked->sblock[i+1]-shaked->sblock[i]);
-        blen /= 3;
-        n0    = vec_shakef(log, shaked, invmass, blen, idef.iparams,
-                           iatoms, ir.shake_tol, x_s, prime, shaked->omega,
-                           ir.efep != efepNO, lambda, lam, invdt, v, bCalcVir, vir_r_m_dr,
-                           econq);
+    /* When the blocks do not share atoms, they can be constrained
+     * independently by different threads. Each block iterates exactly
+     * as in the serial case, so the convergence is not affected.
+     */
+    const int                      numThreads =
+        (shaked->blocksAreIndependent ?
+         std::max(1, std::min(gmx_omp_nthreads_get(emntLINCS), shaked->nblocks)) : 1);
+    std::vector<ShakeThreadOutput> threadOutput(numThreads);
 
-        if (n0 == 0)
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
         {
-            if (bDumpOnError && log)
+            ShakeThreadOutput &output     = threadOutput[thread];
+            const int          blockBegin = shakeBlockStart(*shaked, ncon, numThreads, thread);
+            const int          blockEnd   = shakeBlockStart(*shaked, ncon, numThreads, thread + 1);
+            for (int b = blockBegin; b < blockEnd; b++)
             {
+                const int conOffset = shaked->sblock[b]/3;
+                const int blen      = shaked->sblock[b + 1]/3 - conOffset;
+                const int n0        =
+                    vec_shakef(&output.errorMessage, shaked, conOffset, invmass, blen, idef.iparams,
+                               idef.il[F_CONSTR].iatoms + 3*conOffset, ir.shake_tol,
+                               x_s, prime, shaked->omega,
+                               ir.efep != efepNO, lambda,
+                               shaked->scaled_lagrange_multiplier + conOffset,
+                               invdt, v, bCalcVir, output.virial, econq);
+
+                if (n0 == 0)
                 {
-                    check_cons(log, blen, x_s, prime, v, idef.iparams, iatoms, invmass, econq);
+                    output.failedBlock = b;
+                    break;
                 }
+                output.numIterations  += n0*blen;
+                output.numConstraints += blen;
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+
+    /* Reduce in thread order, so the result does not depend on timing.
+     * Only the first failure is reported, as with a single thread.
+     */
+    for (const ShakeThreadOutput &output : threadOutput)
+    {
+        if (output.failedBlock >= 0)
+        {
+            if (log)
+            {
+                fprintf(log, "%s", output.errorMessage.c_str());
+            }
+            fprintf(stderr, "%s", output.errorMessage.c_str());
+            if (bDumpOnError && log)
+            {
+                const int conOffset = shaked->sblock[output.failedBlock]/3;
+                const int blen      = shaked->sblock[output.failedBlock + 1]/3 - conOffset;
+                check_cons(log, blen, x_s, prime, v, idef.iparams,
+                           idef.il[F_CONSTR].iatoms + 3*conOffset, invmass, econq);
             }
             return FALSE;
         }
-        tnit                       += n0*blen;
-        trij                       += blen;
-        iatoms                     += 3*blen; /* Increment pointer! */
-        lam                        += blen;
-        i++;
+        tnit += output.numIterations;
+        trij += output.numConstraints;
+        if (bCalcVir)
+        {
+            m_add(vir_r_m_dr, output.virial, vir_r_m_dr);
+        }
     }
     /* only for position part? */
     if (econq == ConstraintVariable::Positions)
@@ -80,6 +80,7 @@
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/ppforceworkload.h"
 #include "gromacs/mdlib/qmmm.h"
+#include "gromacs/mdlib/threadteam.h"
 #include "gromacs/mdlib/update.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/enerdata.h"
@@ -131,12 +132,14 @@ static void sum_forces(rvec f[], gmx::ArrayRef<const gmx::RVec> forceToAdd)
 {
     const int      end = forceToAdd.size();
 
-    int gmx_unused nt = gmx_omp_nthreads_get(emntDefault);
-#pragma omp parallel for num_threads(nt) schedule(static)
-    for (int i = 0; i < end; i++)
-    {
-        rvec_inc(f[i], forceToAdd[i]);
-    }
+    const int      nt  = gmx_omp_nthreads_get(emntDefault);
+    gmx::runThreadTasks(nt, [&](int thread)
+                        {
+                            for (int i = (end*thread)/nt; i < (end*(thread + 1))/nt; i++)
+                            {
+                                rvec_inc(f[i], forceToAdd[i]);
+                            }
+                        });
 }
 
 static void calc_virial(int start, int homenr, const rvec x[], const rvec f[],
@@ -316,7 +319,8 @@ static void do_nb_verlet(t_forcerec                       *fr,
                          const int                         clearF,
                          const int64_t                     step,
                          t_nrnb                           *nrnb,
-                         gmx_wallcycle_t                   wcycle)
+                         gmx_wallcycle_t                   wcycle,
+                         const Nbnxm::OverlapTasks        *overlapTasks = nullptr)
 {
     if (!(flags & GMX_FORCE_NONBONDED))
     {
@@ -346,15 +350,24 @@ static void do_nb_verlet(t_forcerec                       *fr,
             nbv->dispatchPruneKernelCpu(ilocality, fr->shift_vec);
             wallcycle_sub_stop(wcycle, ewcsNONBONDED_PRUNING);
         }
+    }
 
-        wallcycle_sub_start(wcycle, ewcsNONBONDED);
+    /* With overlapping tasks, the non-bonded and bonded time cannot be
+     * separated, so we count it with its own sub-counter.
+     */
+    const int nonbondedSubCounter =
+        (overlapTasks != nullptr && overlapTasks->numTasks > 0) ? ewcsNONBONDED_AND_LISTED : ewcsNONBONDED;
+
+    if (!nbv->useGpu())
+    {
+        wallcycle_sub_start(wcycle, nonbondedSubCounter);
     }
 
-    nbv->dispatchNonbondedKernel(ilocality, *ic, flags, clearF, *fr, enerd, nrnb);
+    nbv->dispatchNonbondedKernel(ilocality, *ic, flags, clearF, *fr, enerd, nrnb, overlapTasks);
 
     if (!nbv->useGpu())
     {
-        wallcycle_sub_stop(wcycle, ewcsNONBONDED);
+        wallcycle_sub_stop(wcycle, nonbondedSubCounter);
     }
 }
 
@@ -375,11 +388,13 @@ static inline void clear_rvecs_omp(int n, rvec v[])
     }
     else
     {
-#pragma omp parallel for num_threads(nth) schedule(static)
-        for (int i = 0; i < n; i++)
-        {
-            clear_rvec(v[i]);
-        }
+        gmx::runThreadTasks(nth, [&](int thread)
+                            {
+                                for (int i = (n*thread)/nth; i < (n*(thread + 1))/nth; i++)
+                                {
+                                    clear_rvec(v[i]);
+                                }
+                            });
     }
 }
 
@@ -1250,8 +1265,38 @@ void do_force(FILE                                     *fplog,
 
     if (!bUseOrEmulGPU)
     {
+        /* When possible, we compute the CPU bonded forces as tasks in
+         * the thread team of the local non-bonded kernel. This avoids
+         * a parallel region and lets the bonded work fill the load
+         * imbalance between the non-bonded threads. The thread output
+         * is reduced later, in do_force_lowlevel, as before.
+         * The time of the overlapped tasks is counted with a separate
+         * sub-counter, not the non-bonded or listed sub-counters.
+         */
+        Nbnxm::OverlapTasks bondedTasks;
+        t_pbc               pbcForBondedTasks;
+        if ((flags & GMX_FORCE_LISTED) && (flags & GMX_FORCE_NONBONDED) &&
+            canComputeBondedsAsTasks(*fr, *fcd, graph))
+        {
+            if (fr->bMolPBC)
+            {
+                set_pbc_dd(&pbcForBondedTasks, fr->ePBC, DOMAINDECOMP(cr) ? cr->dd->nc : nullptr,
+                           TRUE, box);
+            }
+            bondedTasks.numTasks = prepareBondedTasks(fr);
+            bondedTasks.runTask  = [&](int task)
+                {
+                    calcBondedForcesTask(task, &top->idef,
+                                         as_rvec_array(x.unpaddedArrayRef().data()), fr,
+                                         &pbcForBondedTasks, enerd, nrnb, lambda.data(),
+                                         mdatoms, fcd,
+                                         DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr,
+                                         flags);
+                };
+        }
+
         do_nb_verlet(fr, ic, enerd, flags, Nbnxm::InteractionLocality::Local, enbvClearFYes,
-                     step, nrnb, wcycle);
+                     step, nrnb, wcycle, &bondedTasks);
     }
 
     if (fr->efep != efepNO)
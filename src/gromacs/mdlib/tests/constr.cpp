@@ -418,7 +418,9 @@ static std::vector<std::string> algorithmsNames;
 static std::vector<std::string> getAlgorithmsNames()
 {
     algorithmsNames.emplace_back("SHAKE");
+    algorithmsNames.emplace_back("SHAKE_THREADED");
     algorithmsNames.emplace_back("LINCS");
+    algorithmsNames.emplace_back("LINCS_THREADED");
     std::string errorMessage;
     if (GMX_GPU == GMX_GPU_CUDA && canDetectGpus(&errorMessage))
     {
@@ -482,8 +484,12 @@ class ConstraintsTest : public ::testing::TestWithParam<ConstraintsTestParameter
             //
             // SHAKE
             algorithms_["SHAKE"] = applyShake;
+            // SHAKE with the blocks distributed over threads
+            algorithms_["SHAKE_THREADED"] = applyShakeThreaded;
             // LINCS
             algorithms_["LINCS"] = applyLincs;
+            // LINCS with the constraints distributed over threads
+            algorithms_["LINCS_THREADED"] = applyLincsThreaded;
             // LINCS using CUDA (will be called only if CUDA is available)
             algorithms_["LINCS_CUDA"] = applyLincsCuda;
         }
@@ -495,6 +501,30 @@ class ConstraintsTest : public ::testing::TestWithParam<ConstraintsTestParameter
          * \param[in] pbc             Periodic boundary data (not used in SHAKE).
          */
         static void applyShake(ConstraintsTestData *testData, t_pbc gmx_unused pbc)
+        {
+            gmx_omp_nthreads_set(emntLINCS, 1);
+            applyShakeWithCurrentThreads(testData);
+        }
+
+        /*! \brief
+         * Initialize and apply SHAKE constraints using two threads.
+         *
+         * \param[in] testData        Test data structure.
+         * \param[in] pbc             Periodic boundary data (not used in SHAKE).
+         */
+        static void applyShakeThreaded(ConstraintsTestData *testData, t_pbc gmx_unused pbc)
+        {
+            gmx_omp_nthreads_set(emntLINCS, 2);
+            applyShakeWithCurrentThreads(testData);
+            gmx_omp_nthreads_set(emntLINCS, 1);
+        }
+
+        /*! \brief
+         * Initialize and apply SHAKE constraints with the number of threads set for LINCS.
+         *
+         * \param[in] testData        Test data structure.
+         */
+        static void applyShakeWithCurrentThreads(ConstraintsTestData *testData)
         {
             shakedata* shaked = shake_init();
             make_shake_sblock_serial(shaked, &testData->idef_, testData->md_);
@@ -527,12 +557,36 @@ class ConstraintsTest : public ::testing::TestWithParam<ConstraintsTestParameter
          * \param[in] pbc             Periodic boundary data.
          */
         static void applyLincs(ConstraintsTestData *testData, t_pbc pbc)
+        {
+            gmx_omp_nthreads_set(emntLINCS, 1);
+            applyLincsWithCurrentThreads(testData, pbc);
+        }
+
+        /*! \brief
+         * Initialize and apply LINCS constraints using two threads.
+         *
+         * \param[in] testData        Test data structure.
+         * \param[in] pbc             Periodic boundary data.
+         */
+        static void applyLincsThreaded(ConstraintsTestData *testData, t_pbc pbc)
+        {
+            gmx_omp_nthreads_set(emntLINCS, 2);
+            applyLincsWithCurrentThreads(testData, pbc);
+            gmx_omp_nthreads_set(emntLINCS, 1);
+        }
+
+        /*! \brief
+         * Initialize and apply LINCS constraints with the number of threads set for LINCS.
+         *
+         * \param[in] testData        Test data structure.
+         * \param[in] pbc             Periodic boundary data.
+         */
+        static void applyLincsWithCurrentThreads(ConstraintsTestData *testData, t_pbc pbc)
         {
 
             Lincs                *lincsd;
             int                   maxwarn         = 100;
             int                   warncount_lincs = 0;
-            gmx_omp_nthreads_set(emntLINCS, 1);
 
             // Make blocka structure for faster LINCS setup
             std::vector<t_blocka> at2con_mt;
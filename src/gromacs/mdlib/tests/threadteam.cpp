@@ -0,0 +1,146 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the persistent thread team
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/threadteam.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of threads in the teams tested
+constexpr int c_numThreads = 4;
+
+//! Runs \p numPhases phases on \p numThreadsToUse threads and returns the call counts per thread
+std::vector<int> runPhases(ThreadTeam *team, int numThreadsToUse, int numPhases)
+{
+    std::vector < std::atomic < int>> counts(c_numThreads);
+    for (auto &count : counts)
+    {
+        count = 0;
+    }
+
+    for (int phase = 0; phase < numPhases; phase++)
+    {
+        team->run(numThreadsToUse, [&counts](int thread) { counts[thread]++; });
+    }
+
+    std::vector<int> result;
+    for (auto &count : counts)
+    {
+        result.push_back(count);
+    }
+
+    return result;
+}
+
+TEST(ThreadTeamTest, RunsEachThreadOncePerPhase)
+{
+    ThreadTeam team(c_numThreads);
+
+    EXPECT_EQ(c_numThreads, team.numThreads());
+    EXPECT_EQ(std::vector<int>(c_numThreads, 100), runPhases(&team, c_numThreads, 100));
+}
+
+TEST(ThreadTeamTest, RunsOnFewerThreads)
+{
+    ThreadTeam team(c_numThreads);
+
+    EXPECT_EQ(std::vector<int>({ 10, 10, 0, 0 }), runPhases(&team, 2, 10));
+    EXPECT_EQ(std::vector<int>({ 10, 0, 0, 0 }), runPhases(&team, 1, 10));
+}
+
+TEST(ThreadTeamTest, WakesUpSleepingThreads)
+{
+    ThreadTeam team(c_numThreads);
+
+    for (int i = 0; i < 3; i++)
+    {
+        /* Give the workers time to go to sleep */
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        EXPECT_EQ(std::vector<int>(c_numThreads, 1), runPhases(&team, c_numThreads, 1));
+    }
+}
+
+TEST(ThreadTeamTest, ThreadsSeeDataOfPreviousPhase)
+{
+    ThreadTeam       team(c_numThreads);
+    std::vector<int> data(c_numThreads*100, 0);
+
+    for (int phase = 0; phase < 50; phase++)
+    {
+        /* Each thread increments the elements written by the next thread in the previous phase */
+        team.run(c_numThreads, [&data, phase](int thread)
+                 {
+                     const int sourceThread = (thread + phase) % c_numThreads;
+                     for (int i = sourceThread*100; i < (sourceThread + 1)*100; i++)
+                     {
+                         data[i]++;
+                     }
+                 });
+    }
+
+    EXPECT_EQ(std::vector<int>(c_numThreads*100, 50), data);
+}
+
+TEST(ThreadTeamTest, RunThreadTasksRunsAllTasks)
+{
+    std::vector<int> counts(c_numThreads, 0);
+
+    runThreadTasks(c_numThreads, [&counts](int thread) { counts[thread]++; });
+
+    EXPECT_EQ(std::vector<int>(c_numThreads, 1), counts);
+}
+
+}  // namespace
+
+}  // namespace test
+}  // namespace gmx
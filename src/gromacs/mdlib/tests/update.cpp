@@ -0,0 +1,274 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the coordinate update
+ *
+ * Checks that the kinetic energy accumulated during the update
+ * matches the kinetic energy computed afterwards by calc_ke_part().
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/update.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdlib/tgroup.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/group.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/alignedallocator.h"
+#include "gromacs/utility/real.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of atoms, chosen such that the update uses several blocks
+constexpr int c_numAtoms = 1000;
+//! Number of temperature-coupling groups
+constexpr int c_numTempGroups = 2;
+
+//! Results of an update followed by the kinetic energy computation
+struct UpdateOutput
+{
+    //! Updated coordinates
+    std::vector<RVec> xprime;
+    //! Updated velocities
+    std::vector<RVec> v;
+    //! Half-step kinetic energy tensors per T-coupling group
+    std::vector<RVec> ekinh;
+};
+
+/*! \brief Test fixture for the update, parametrized on the integrator */
+class UpdateKineticEnergyTest : public ::testing::TestWithParam<int>
+{
+    protected:
+        //! Sets up a system with two T-coupling groups
+        UpdateKineticEnergyTest() :
+            md_(),
+            cr_(),
+            nrnb_()
+        {
+            ir_.eI      = GetParam();
+            ir_.delta_t = 0.002;
+            ir_.ld_seed = 1234;
+
+            t_grpopts &opts = ir_.opts;
+            opts.ngtc  = c_numTempGroups;
+            opts.ngacc = 1;
+            opts.ngfrz = 1;
+            snew(opts.tau_t, c_numTempGroups);
+            snew(opts.ref_t, c_numTempGroups);
+            snew(opts.nrdf, c_numTempGroups);
+            snew(opts.annealing, c_numTempGroups);
+            snew(opts.anneal_npoints, c_numTempGroups);
+            snew(opts.anneal_time, c_numTempGroups);
+            snew(opts.anneal_temp, c_numTempGroups);
+            snew(opts.acc, 1);
+            snew(opts.nFreeze, 1);
+            for (int g = 0; g < c_numTempGroups; g++)
+            {
+                opts.tau_t[g] = 0.5 + g;
+                opts.ref_t[g] = 300;
+            }
+
+            /* As in mdatoms, the SIMD update needs aligned inverse masses
+             * that are padded with zeros.
+             */
+            invmass_.resize(c_numAtoms + GMX_REAL_MAX_SIMD_WIDTH, 0);
+            invMassPerDim_.resize(c_numAtoms);
+            massT_.resize(c_numAtoms);
+            ptype_.resize(c_numAtoms, eptAtom);
+            cTC_.resize(c_numAtoms);
+            x_.resize(c_numAtoms);
+            v_.resize(c_numAtoms);
+            f_.resize(c_numAtoms);
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                massT_[a]   = 1.0 + a % 16;
+                invmass_[a] = 1/massT_[a];
+                for (int d = 0; d < DIM; d++)
+                {
+                    invMassPerDim_[a][d] = invmass_[a];
+                    x_[a][d]             = 0.01*((a*(d + 3)) % 101);
+                    v_[a][d]             = 0.1*(((a*(d + 7)) % 23) - 11);
+                    f_[a][d]             = 10.0*(((a*(d + 5)) % 17) - 8);
+                }
+                cTC_[a] = a % c_numTempGroups;
+            }
+
+            md_.homenr         = c_numAtoms;
+            md_.invmass        = invmass_.data();
+            md_.invMassPerDim  = as_rvec_array(invMassPerDim_.data());
+            md_.massT          = massT_.data();
+            md_.ptype          = ptype_.data();
+            md_.cTC            = cTC_.data();
+
+            cr_.nnodes = 1;
+            cr_.dd     = nullptr;
+        }
+
+        //! Runs the update with or without accumulating the kinetic energy and computes it
+        UpdateOutput updateAndComputeKineticEnergy(bool accumulateDuringUpdate)
+        {
+            /* The kinetic energy setup only needs an empty topology */
+            gmx_mtop_t     mtop;
+            mtop.moltype.resize(1);
+            mtop.molblock.resize(1);
+            gmx_ekindata_t ekind {};
+            init_ekindata(nullptr, &mtop, &ir_.opts, &ekind);
+
+            t_state state;
+            state.x.resizeWithPadding(c_numAtoms);
+            state.v.resizeWithPadding(c_numAtoms);
+            PaddedVector<RVec> f;
+            f.resizeWithPadding(c_numAtoms);
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                state.x[a] = x_[a];
+                state.v[a] = v_[a];
+                f[a]       = f_[a];
+            }
+
+            Update upd(&ir_, nullptr);
+            upd.setNumAtoms(c_numAtoms);
+            update_temperature_constants(upd.sd(), &ir_);
+
+            matrix M = { { 0 } };
+            update_coords(0, &ir_, &md_, &state, f.arrayRefWithPadding(), nullptr,
+                          &ekind, M, &upd, etrtPOSITION, &cr_, nullptr,
+                          accumulateDuringUpdate);
+            EXPECT_EQ(accumulateDuringUpdate, static_cast<bool>(ekind.bEkinhFromUpdate));
+
+            calc_ke_part(&state, &ir_.opts, &md_, &ekind, &nrnb_, FALSE);
+            EXPECT_FALSE(ekind.bEkinhFromUpdate);
+
+            UpdateOutput output;
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                output.xprime.push_back((*upd.xp())[a]);
+                output.v.push_back(state.v[a]);
+            }
+            for (int g = 0; g < c_numTempGroups; g++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    output.ekinh.emplace_back(ekind.tcstat[g].ekinh[d]);
+                }
+            }
+
+            return output;
+        }
+
+        //! Input record
+        t_inputrec        ir_;
+        //! Atom data
+        t_mdatoms         md_;
+        //! Communication record
+        t_commrec         cr_;
+        //! Flop counters
+        t_nrnb            nrnb_;
+        //! Inverse masses
+        std::vector<real, AlignedAllocator<real> > invmass_;
+        //! Inverse masses per dimension
+        std::vector<RVec> invMassPerDim_;
+        //! Masses
+        std::vector<real> massT_;
+        //! Particle types
+        std::vector<unsigned short> ptype_;
+        //! T-coupling group indices
+        std::vector<unsigned short> cTC_;
+        //! Initial coordinates
+        std::vector<RVec> x_;
+        //! Initial velocities
+        std::vector<RVec> v_;
+        //! Forces
+        std::vector<RVec> f_;
+};
+
+TEST_P(UpdateKineticEnergyTest, AccumulatedKineticEnergyMatchesSeparateComputation)
+{
+    /* Use multiple threads, when supported, to test the thread reduction */
+    int numThreadsOrig = gmx_omp_nthreads_get(emntUpdate);
+    gmx_omp_nthreads_set(emntUpdate, 2);
+
+    const UpdateOutput reference = updateAndComputeKineticEnergy(false);
+    const UpdateOutput output    = updateAndComputeKineticEnergy(true);
+
+    gmx_omp_nthreads_set(emntUpdate, numThreadsOrig);
+
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(reference.xprime[a][d], output.xprime[a][d]);
+            EXPECT_EQ(reference.v[a][d], output.v[a][d]);
+        }
+    }
+
+    const FloatingPointTolerance tolerance = relativeToleranceAsFloatingPoint(1e4, 1e-5);
+    for (size_t i = 0; i < reference.ekinh.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.ekinh[i][d], output.ekinh[i][d], tolerance);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithIntegrators, UpdateKineticEnergyTest,
+                            ::testing::Values(eiMD, eiSD1));
+
+}  // namespace
+
+}  // namespace test
+}  // namespace gmx
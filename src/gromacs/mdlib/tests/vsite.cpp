@@ -0,0 +1,258 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for virtual site construction and force spreading
+ *
+ * Checks that the SIMD batched construction and spreading give
+ * the same results as the plain-C code, with and without PBC.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/vsite.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of molecules, chosen such that any SIMD width needs a remainder
+constexpr int c_numMolecules = 37;
+//! Number of atoms per molecule, three real atoms and three vsites
+constexpr int c_numAtomsPerMolecule = 6;
+//! Total number of atoms
+constexpr int c_numAtoms = c_numMolecules*c_numAtomsPerMolecule;
+
+//! Results of vsite construction and force spreading
+struct VsiteOutput
+{
+    //! Coordinates after construction
+    std::vector<RVec> x;
+    //! Vsite velocities
+    std::vector<RVec> v;
+    //! Forces after spreading
+    std::vector<RVec> f;
+    //! Virial correction
+    matrix            virial = { { 0 } };
+};
+
+/*! \brief Test fixture for vsites, parametrized on the use of PBC
+ *
+ * Each molecule has one vsite of each type F_VSITE2, F_VSITE3 and
+ * F_VSITE3FD, all constructed from the same three atoms.
+ */
+class VsiteTest : public ::testing::TestWithParam<bool>
+{
+    protected:
+        //! Sets up the molecules, with PBC every third molecule is broken over the box
+        VsiteTest() :
+            idef_()
+        {
+            usePbc_ = GetParam();
+
+            clear_mat(box_);
+            box_[XX][XX] = 2.5;
+            box_[YY][YY] = 2.7;
+            box_[ZZ][ZZ] = 2.3;
+
+            t_iparams ip;
+            ip.vsite.a = 0.3;
+            ip.vsite.b = 0.0;
+            iparams_.push_back(ip);
+            ip.vsite.a = 0.128;
+            ip.vsite.b = 0.134;
+            iparams_.push_back(ip);
+            ip.vsite.a = 0.45;
+            ip.vsite.b = 0.06;
+            iparams_.push_back(ip);
+
+            x_.resize(c_numAtoms);
+            f_.resize(c_numAtoms);
+            for (int m = 0; m < c_numMolecules; m++)
+            {
+                const int  a0 = m*c_numAtomsPerMolecule;
+                const RVec xi = { box_[XX][XX]*((m*7) % 37)/37.0f,
+                                  box_[YY][YY]*((m*11) % 37)/37.0f,
+                                  box_[ZZ][ZZ]*((m*5) % 37)/37.0f };
+                x_[a0]     = xi;
+                x_[a0 + 1] = { xi[XX] + 0.08f + 0.002f*(m % 5), xi[YY] + 0.05f, xi[ZZ] - 0.02f };
+                x_[a0 + 2] = { xi[XX] - 0.03f, xi[YY] + 0.09f - 0.003f*(m % 3), xi[ZZ] + 0.04f };
+                if (usePbc_ && m % 3 == 0)
+                {
+                    /* Put the second atom in a different periodic image */
+                    x_[a0 + 1][XX] -= box_[XX][XX];
+                    x_[a0 + 1][ZZ] += box_[ZZ][ZZ];
+                }
+                /* Start the vsites at the first atom */
+                for (int a = 3; a < c_numAtomsPerMolecule; a++)
+                {
+                    x_[a0 + a] = xi;
+                }
+
+                iatomsVsite2_.insert(iatomsVsite2_.end(), { 0, a0 + 3, a0, a0 + 1 });
+                iatomsVsite3_.insert(iatomsVsite3_.end(), { 1, a0 + 4, a0, a0 + 1, a0 + 2 });
+                iatomsVsite3FD_.insert(iatomsVsite3FD_.end(), { 2, a0 + 5, a0, a0 + 1, a0 + 2 });
+
+                for (int a = 0; a < c_numAtomsPerMolecule; a++)
+                {
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        f_[a0 + a][d] = 10.0*(((a0 + a)*(d + 3) % 19) - 9);
+                    }
+                }
+            }
+
+            idef_.iparams               = iparams_.data();
+            idef_.il[F_VSITE2].nr       = iatomsVsite2_.size();
+            idef_.il[F_VSITE2].iatoms   = iatomsVsite2_.data();
+            idef_.il[F_VSITE3].nr       = iatomsVsite3_.size();
+            idef_.il[F_VSITE3].iatoms   = iatomsVsite3_.data();
+            idef_.il[F_VSITE3FD].nr     = iatomsVsite3FD_.size();
+            idef_.il[F_VSITE3FD].iatoms = iatomsVsite3FD_.data();
+
+            vsite_.numInterUpdategroupVsites = (usePbc_ ? c_numMolecules : 0);
+            vsite_.nthreads                  = 1;
+            vsite_.useDomdec                 = false;
+        }
+
+        //! Constructs the vsites and spreads the forces, using SIMD when \p useSimd is true
+        VsiteOutput constructAndSpread(bool useSimd)
+        {
+            vsite_.useSimd = useSimd;
+
+            PaddedVector<RVec> x;
+            PaddedVector<RVec> v;
+            PaddedVector<RVec> f;
+            x.resizeWithPadding(c_numAtoms);
+            v.resizeWithPadding(c_numAtoms);
+            f.resizeWithPadding(c_numAtoms);
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                x[a] = x_[a];
+                v[a] = { 0, 0, 0 };
+                f[a] = f_[a];
+            }
+
+            const int ePBC = (usePbc_ ? epbcXYZ : epbcNONE);
+            construct_vsites(&vsite_, x.rvec_array(), 0.002, v.rvec_array(),
+                             idef_.iparams, idef_.il, ePBC, TRUE, nullptr, box_);
+
+            VsiteOutput output;
+            t_nrnb      nrnb;
+            init_nrnb(&nrnb);
+            spread_vsite_f(&vsite_, x.rvec_array(), f.rvec_array(), nullptr,
+                           TRUE, output.virial, &nrnb, &idef_, ePBC, TRUE,
+                           nullptr, box_, nullptr, nullptr);
+
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                output.x.push_back(x[a]);
+                output.v.push_back(v[a]);
+                output.f.push_back(f[a]);
+            }
+
+            return output;
+        }
+
+        //! Whether to use PBC
+        bool                   usePbc_;
+        //! The box
+        matrix                 box_;
+        //! Initial coordinates
+        std::vector<RVec>      x_;
+        //! Forces before spreading
+        std::vector<RVec>      f_;
+        //! Interaction parameters
+        std::vector<t_iparams> iparams_;
+        //! F_VSITE2 interaction list
+        std::vector<t_iatom>   iatomsVsite2_;
+        //! F_VSITE3 interaction list
+        std::vector<t_iatom>   iatomsVsite3_;
+        //! F_VSITE3FD interaction list
+        std::vector<t_iatom>   iatomsVsite3FD_;
+        //! Interaction definitions
+        t_idef                 idef_;
+        //! The vsite setup
+        gmx_vsite_t            vsite_;
+};
+
+TEST_P(VsiteTest, SimdMatchesReference)
+{
+    const VsiteOutput reference = constructAndSpread(false);
+    const VsiteOutput output    = constructAndSpread(true);
+
+    const FloatingPointTolerance coordTolerance = relativeToleranceAsFloatingPoint(1.0, 1e-5);
+    const FloatingPointTolerance tolerance      = relativeToleranceAsFloatingPoint(100.0, 1e-5);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.x[a][d], output.x[a][d], coordTolerance) << "atom " << a;
+            EXPECT_REAL_EQ_TOL(reference.v[a][d], output.v[a][d], tolerance) << "atom " << a;
+            EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], tolerance) << "atom " << a;
+        }
+    }
+    for (int d1 = 0; d1 < DIM; d1++)
+    {
+        for (int d2 = 0; d2 < DIM; d2++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.virial[d1][d2], output.virial[d1][d2], tolerance);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithPbc, VsiteTest, ::testing::Bool());
+
+}  // namespace
+
+}  // namespace test
+}  // namespace gmx
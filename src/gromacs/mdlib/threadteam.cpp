@@ -0,0 +1,202 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief Implements the persistent thread team
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "threadteam.h"
+
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/timing/wallcycle.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
+
+namespace gmx
+{
+
+/*! \brief The number of times a worker polls for a new phase before going to sleep
+ *
+ * Between polls, the worker pauses the CPU, which leaves more execution
+ * resources to the other hardware thread on the core.
+ *
+ * This should cover the time between the short phases within an MD step,
+ * but should be short enough to not take compute resources away from
+ * OpenMP threads running on the same cores for long.
+ */
+static constexpr int c_numSpinsBeforeSleep = 10000;
+
+ThreadTeam::ThreadTeam(int numThreads) :
+    numThreads_(numThreads),
+    phaseCounter_(0),
+    numWorkersDone_(0),
+    numWorkersSleeping_(0),
+    stop_(false)
+{
+    GMX_RELEASE_ASSERT(numThreads >= 1, "A thread team needs at least one thread");
+
+    for (int thread = 1; thread < numThreads_; thread++)
+    {
+        workers_.emplace_back(&ThreadTeam::workerLoop, this, thread);
+    }
+}
+
+ThreadTeam::~ThreadTeam()
+{
+    stop_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        phaseCounter_++;
+    }
+    wakeUp_.notify_all();
+
+    for (auto &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadTeam::run(int                              numThreadsToUse,
+                     const std::function<void(int)>  &phase)
+{
+    GMX_ASSERT(numThreadsToUse >= 1 && numThreadsToUse <= numThreads_, "The number of threads should be within the team size");
+
+    wallcycle_sub_start(wcycle_, ewcsTHREAD_TEAM_START);
+
+    phase_             = &phase;
+    numThreadsInPhase_ = numThreadsToUse;
+    numWorkersDone_    = 0;
+    /* The increment publishes the phase data set above to the workers */
+    phaseCounter_++;
+    /* A worker increments the sleep count before checking the phase
+     * counter with the mutex locked. So either we see its increment
+     * here, or it will see the new phase without waiting.
+     */
+    if (numWorkersSleeping_ > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeUp_.notify_all();
+    }
+
+    wallcycle_sub_stop(wcycle_, ewcsTHREAD_TEAM_START);
+
+    try
+    {
+        phase(0);
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+
+    wallcycle_sub_start(wcycle_, ewcsTHREAD_TEAM_BARRIER);
+
+    while (numWorkersDone_.load(std::memory_order_acquire) < numThreads_ - 1)
+    {
+        gmx_pause();
+    }
+
+    wallcycle_sub_stop(wcycle_, ewcsTHREAD_TEAM_BARRIER);
+}
+
+void ThreadTeam::workerLoop(int thread)
+{
+    int phaseSeen = 0;
+
+    while (true)
+    {
+        for (int spin = 0; spin < c_numSpinsBeforeSleep && phaseCounter_.load(std::memory_order_acquire) == phaseSeen; spin++)
+        {
+            gmx_pause();
+        }
+        if (phaseCounter_.load(std::memory_order_acquire) == phaseSeen)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            numWorkersSleeping_++;
+            wakeUp_.wait(lock, [this, phaseSeen] { return phaseCounter_ != phaseSeen; });
+            numWorkersSleeping_--;
+        }
+        /* The caller waits for all workers before starting the next
+         * phase, so the counter is always one ahead of us here.
+         */
+        phaseSeen++;
+
+        if (stop_)
+        {
+            return;
+        }
+
+        if (thread < numThreadsInPhase_)
+        {
+            try
+            {
+                (*phase_)(thread);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+
+        numWorkersDone_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void runThreadTasks(int                              numThreads,
+                    const std::function<void(int)>  &task)
+{
+    ThreadTeam *threadTeam = gmx_omp_nthreads_get_thread_team();
+
+    if (numThreads == 1)
+    {
+        task(0);
+    }
+    else if (threadTeam != nullptr && numThreads <= threadTeam->numThreads())
+    {
+        threadTeam->run(numThreads, task);
+    }
+    else
+    {
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (int thread = 0; thread < numThreads; thread++)
+        {
+            try
+            {
+                task(thread);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+    }
+}
+
+} // namespace gmx
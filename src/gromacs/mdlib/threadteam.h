@@ -0,0 +1,151 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ *
+ * \brief Declares a persistent thread team as a light-weight
+ * alternative to OpenMP parallel regions for short loops
+ *
+ * Each OpenMP parallel region in the MD step has a fork/join and
+ * barrier overhead of a few microseconds. For small systems with
+ * many threads this overhead is significant. The team keeps its
+ * threads spinning for a short time between phases, so phases that
+ * follow each other quickly are started without a system call.
+ *
+ * The team is only used when the environment variable
+ * GMX_USE_THREAD_TEAM is set. The time the calling thread spends
+ * starting the phases and waiting for the other threads is measured
+ * in wallcycle sub-counters.
+ *
+ * \ingroup module_mdlib
+ * \inlibraryapi
+ */
+#ifndef GMX_MDLIB_THREADTEAM_H
+#define GMX_MDLIB_THREADTEAM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gromacs/utility/classhelpers.h"
+
+struct gmx_wallcycle;
+
+namespace gmx
+{
+
+/*! \libinternal
+ * \brief A team of persistent threads that runs phases of work
+ *
+ * The calling thread acts as thread 0 of the team. A call to run()
+ * returns after all threads have finished the phase, so run() acts
+ * as a fork and join. The phase function should not use OpenMP.
+ *
+ * A team should only be used by the thread that created it.
+ */
+class ThreadTeam
+{
+    public:
+        //! Constructs a team of \p numThreads threads, including the calling thread
+        explicit ThreadTeam(int numThreads);
+
+        ~ThreadTeam();
+
+        //! Returns the number of threads in the team
+        int numThreads() const
+        {
+            return numThreads_;
+        }
+
+        /*! \brief Sets the cycle counting object for timing the overhead, can be nullptr
+         *
+         * Must be cleared before \p wcycle is destroyed.
+         */
+        void setWallcycle(gmx_wallcycle *wcycle)
+        {
+            wcycle_ = wcycle;
+        }
+
+        /*! \brief Runs \p phase(thread) for thread = 0, ..., \p numThreadsToUse - 1
+         *
+         * \p numThreadsToUse should be at most numThreads().
+         */
+        void run(int                              numThreadsToUse,
+                 const std::function<void(int)>  &phase);
+
+    private:
+        //! The loop executed by the worker threads
+        void workerLoop(int thread);
+
+        //! The number of threads in the team
+        int                               numThreads_;
+        //! The worker threads, thread 0 is the calling thread and not stored
+        std::vector<std::thread>          workers_;
+        //! The phase to run, only valid during run()
+        const std::function<void(int)>   *phase_ = nullptr;
+        //! The number of threads that run the current phase
+        int                               numThreadsInPhase_ = 0;
+        //! Counter that is incremented to start a phase
+        std::atomic<int>                  phaseCounter_;
+        //! The number of worker threads that finished the current phase
+        std::atomic<int>                  numWorkersDone_;
+        //! The number of worker threads waiting on the condition variable
+        std::atomic<int>                  numWorkersSleeping_;
+        //! Tells the worker threads to exit
+        std::atomic<bool>                 stop_;
+        //! Mutex for waking up sleeping workers
+        std::mutex                        mutex_;
+        //! Condition variable for waking up sleeping workers
+        std::condition_variable           wakeUp_;
+        //! Cycle counting, can be nullptr
+        gmx_wallcycle                    *wcycle_ = nullptr;
+
+        GMX_DISALLOW_COPY_AND_ASSIGN(ThreadTeam);
+};
+
+/*! \brief Runs \p task(thread) for thread = 0, ..., \p numThreads - 1 in parallel
+ *
+ * Uses the thread team of this rank, when in use and large enough,
+ * and an OpenMP parallel region otherwise. \p task should not use
+ * OpenMP and should not depend on the OpenMP thread index.
+ */
+void runThreadTasks(int                              numThreads,
+                    const std::function<void(int)>  &task);
+
+} // namespace gmx
+
+#endif
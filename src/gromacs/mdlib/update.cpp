@@ -39,9 +39,11 @@
 #include "update.h"
 
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 
 #include "gromacs/domdec/domdec_struct.h"
@@ -62,6 +64,7 @@
 #include "gromacs/mdlib/mdatoms.h"
 #include "gromacs/mdlib/stat.h"
 #include "gromacs/mdlib/tgroup.h"
+#include "gromacs/mdlib/threadteam.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/group.h"
 #include "gromacs/mdtypes/inputrec.h"
@@ -851,6 +854,66 @@ void Update::setNumAtoms(int nAtoms)
     impl_->xp.resizeWithPadding(nAtoms);
 }
 
+/*! \brief The number of atoms for which we generate random values at once
+ *
+ * Generating the random values for a batch of atoms allows the compiler
+ * to vectorize the ThreeFry encryption rounds over the atoms.
+ */
+static constexpr int c_randomBatchSize = 64;
+
+//! The number of table bits of the normal distribution for SD and BD
+static constexpr unsigned int c_normalDistributionTableBits = 14;
+
+/*! \brief Random engine that returns a precomputed 64-bit random value
+ *
+ * With the table size of TabulatedNormalDistribution we use, all DIM
+ * normal distributed numbers needed for an atom come from the first
+ * 64-bit value of the ThreeFry stream of the atom. We generate these
+ * values for many atoms at once and feed them to the distribution
+ * through this class, so we get identical results as with restarting
+ * the ThreeFry engine for each atom.
+ */
+class PrecomputedRandomValue
+{
+    public:
+        //! The type of the random value
+        typedef uint64_t result_type;
+
+        //! Constructor
+        explicit PrecomputedRandomValue(uint64_t value) : value_(value) {}
+
+        //! Returns the random value
+        result_type operator()() { return value_; }
+
+    private:
+        //! The random value
+        uint64_t value_;
+};
+
+static_assert(DIM*c_normalDistributionTableBits <= std::numeric_limits<uint64_t>::digits,
+              "We need all normal distributed numbers for an atom to come from one 64-bit value");
+
+/*! \brief Generates the first ThreeFry value for the atoms in the range \p start to \p end
+ *
+ * \p randomValues[n - start] gets the value for atom n.
+ */
+static void
+generateAtomRandomValues(const gmx::ThreeFry2x64<0> &rng,
+                         int start, int end,
+                         int64_t step, const int *gatindex,
+                         uint64_t *randomValues)
+{
+    uint64_t globalAtomIndices[c_randomBatchSize];
+
+    GMX_ASSERT(end - start <= c_randomBatchSize, "Can only generate values for one batch at once");
+
+    for (int n = start; n < end; n++)
+    {
+        globalAtomIndices[n - start] = gatindex ? gatindex[n] : n;
+    }
+    rng.generateFirstResults(step, globalAtomIndices, end - start, randomValues);
+}
+
 /*! \brief Sets the SD update type */
 enum class SDUpdate : int
 {
@@ -901,12 +964,19 @@ doSDUpdateGeneral(const gmx_stochd_t &sd,
 
     // Even 0 bits internal counter gives 2x64 ints (more than enough for three table lookups)
     gmx::ThreeFry2x64<0> rng(seed, gmx::RandomDomain::UpdateCoordinates);
-    gmx::TabulatedNormalDistribution<real, 14> dist;
+    gmx::TabulatedNormalDistribution<real, c_normalDistributionTableBits> dist;
+
+    // Not used, but should be initialized, with forces only
+    uint64_t             randomValues[c_randomBatchSize] = { 0 };
 
     for (int n = start; n < nrend; n++)
     {
-        int globalAtomIndex = gatindex ? gatindex[n] : n;
-        rng.restart(step, globalAtomIndex);
+        if (updateType != SDUpdate::ForcesOnly && (n - start) % c_randomBatchSize == 0)
+        {
+            generateAtomRandomValues(rng, n, std::min(n + c_randomBatchSize, nrend),
+                                     step, gatindex, randomValues);
+        }
+        PrecomputedRandomValue atomRng(randomValues[(n - start) % c_randomBatchSize]);
         dist.reset();
 
         real inverseMass     = invmass[n];
@@ -931,7 +1001,7 @@ doSDUpdateGeneral(const gmx_stochd_t &sd,
                 {
                     real vn      = v[n][d];
                     v[n][d]      = (vn*sd.sdc[temperatureGroup].em +
-                                    invsqrtMass*sd.sdsig[temperatureGroup].V*dist(rng));
+                                    invsqrtMass*sd.sdsig[temperatureGroup].V*dist(atomRng));
                     // The previous phase already updated the
                     // positions with a full v*dt term that must
                     // now be half removed.
@@ -941,7 +1011,7 @@ doSDUpdateGeneral(const gmx_stochd_t &sd,
                 {
                     real vn      = v[n][d] + (inverseMass*f[n][d] + accel[accelerationGroup][d])*dt;
                     v[n][d]      = (vn*sd.sdc[temperatureGroup].em +
-                                    invsqrtMass*sd.sdsig[temperatureGroup].V*dist(rng));
+                                    invsqrtMass*sd.sdsig[temperatureGroup].V*dist(atomRng));
                     // Here we include half of the friction+noise
                     // update of v into the position update.
                     xprime[n][d] = x[n][d] + 0.5*(vn + v[n][d])*dt;
@@ -980,7 +1050,8 @@ static void do_update_bd(int start, int nrend, real dt,
     // Use 1 bit of internal counters to give us 2*2 64-bits values per stream
     // Each 64-bit value is enough for 4 normal distribution table numbers.
     gmx::ThreeFry2x64<0> rng(seed, gmx::RandomDomain::UpdateCoordinates);
-    gmx::TabulatedNormalDistribution<real, 14> dist;
+    gmx::TabulatedNormalDistribution<real, c_normalDistributionTableBits> dist;
+    uint64_t             randomValues[c_randomBatchSize];
 
     if (friction_coefficient != 0)
     {
@@ -989,9 +1060,12 @@ static void do_update_bd(int start, int nrend, real dt,
 
     for (n = start; (n < nrend); n++)
     {
-        int  ng  = gatindex ? gatindex[n] : n;
-
-        rng.restart(step, ng);
+        if ((n - start) % c_randomBatchSize == 0)
+        {
+            generateAtomRandomValues(rng, n, std::min(n + c_randomBatchSize, nrend),
+                                     step, gatindex, randomValues);
+        }
+        PrecomputedRandomValue atomRng(randomValues[(n - start) % c_randomBatchSize]);
         dist.reset();
 
         if (cFREEZE)
@@ -1008,13 +1082,13 @@ static void do_update_bd(int start, int nrend, real dt,
             {
                 if (friction_coefficient != 0)
                 {
-                    vn = invfr*f[n][d] + rf[gt]*dist(rng);
+                    vn = invfr*f[n][d] + rf[gt]*dist(atomRng);
                 }
                 else
                 {
                     /* NOTE: invmass = 2/(mass*friction_constant*dt) */
                     vn = 0.5*invmass[n]*f[n][d]*dt
-                        + std::sqrt(0.5*invmass[n])*rf[gt]*dist(rng);
+                        + std::sqrt(0.5*invmass[n])*rf[gt]*dist(atomRng);
                 }
 
                 v[n][d]      = vn;
@@ -1029,6 +1103,64 @@ static void do_update_bd(int start, int nrend, real dt,
     }
 }
 
+/*! \brief Clears the per-thread kinetic energy accumulation buffers of \p thread */
+static void clearKineticEnergyWork(gmx_ekindata_t *ekind, int thread)
+{
+    for (int g = 0; g < ekind->ngtc; g++)
+    {
+        clear_mat(ekind->ekin_work[thread][g]);
+    }
+    *ekind->dekindl_work[thread] = 0.0;
+}
+
+/*! \brief Adds the kinetic energy tensors of atoms \p start to \p end to \p ekin_sum
+ *
+ * Also adds the mass-perturbation contribution to dEkin/dlambda
+ * to \p dekindl_sum.
+ */
+static void accumulateKineticEnergy(int                             start,
+                                    int                             end,
+                                    const rvec                      v[],
+                                    const t_mdatoms                *md,
+                                    gmx::ArrayRef<const t_grp_acc>  grpstat,
+                                    matrix                         *ekin_sum,
+                                    real                           *dekindl_sum)
+{
+    int ga = 0;
+    int gt = 0;
+    for (int n = start; n < end; n++)
+    {
+        if (md->cACC)
+        {
+            ga = md->cACC[n];
+        }
+        if (md->cTC)
+        {
+            gt = md->cTC[n];
+        }
+        real hm   = 0.5*md->massT[n];
+
+        rvec v_corrt;
+        for (int d = 0; (d < DIM); d++)
+        {
+            v_corrt[d]  = v[n][d]  - grpstat[ga].u[d];
+        }
+        for (int d = 0; (d < DIM); d++)
+        {
+            for (int m = 0; (m < DIM); m++)
+            {
+                /* if we're computing a full step velocity, v_corrt[d] has v(t).  Otherwise, v(t+dt/2) */
+                ekin_sum[gt][m][d] += hm*v_corrt[m]*v_corrt[d];
+            }
+        }
+        if (md->nMassPerturbed && md->bPerturbed[n])
+        {
+            *dekindl_sum +=
+                0.5*(md->massB[n] - md->massA[n])*iprod(v_corrt, v_corrt);
+        }
+    }
+}
+
 static void calc_ke_part_normal(const rvec v[], const t_grpopts *opts, const t_mdatoms *md,
                                 gmx_ekindata_t *ekind, t_nrnb *nrnb, gmx_bool bEkinAveVel)
 {
@@ -1062,65 +1194,23 @@ static void calc_ke_part_normal(const rvec v[], const t_grpopts *opts, const t_m
     ekind->dekindl_old = ekind->dekindl;
     nthread            = gmx_omp_nthreads_get(emntUpdate);
 
-#pragma omp parallel for num_threads(nthread) schedule(static)
-    for (thread = 0; thread < nthread; thread++)
+    /* With leap-frog, update_coords() might already have accumulated
+     * the half-step kinetic energy in the work buffers.
+     */
+    if (!(ekind->bEkinhFromUpdate && !bEkinAveVel))
     {
-        // This OpenMP only loops over arrays and does not call any functions
-        // or memory allocation. It should not be able to throw, so for now
-        // we do not need a try/catch wrapper.
-        int     start_t, end_t, n;
-        int     ga, gt;
-        rvec    v_corrt;
-        real    hm;
-        int     d, m;
-        matrix *ekin_sum;
-        real   *dekindl_sum;
-
-        start_t = ((thread+0)*md->homenr)/nthread;
-        end_t   = ((thread+1)*md->homenr)/nthread;
-
-        ekin_sum    = ekind->ekin_work[thread];
-        dekindl_sum = ekind->dekindl_work[thread];
-
-        for (gt = 0; gt < opts->ngtc; gt++)
-        {
-            clear_mat(ekin_sum[gt]);
-        }
-        *dekindl_sum = 0.0;
-
-        ga = 0;
-        gt = 0;
-        for (n = start_t; n < end_t; n++)
-        {
-            if (md->cACC)
-            {
-                ga = md->cACC[n];
-            }
-            if (md->cTC)
-            {
-                gt = md->cTC[n];
-            }
-            hm   = 0.5*md->massT[n];
-
-            for (d = 0; (d < DIM); d++)
-            {
-                v_corrt[d]  = v[n][d]  - grpstat[ga].u[d];
-            }
-            for (d = 0; (d < DIM); d++)
-            {
-                for (m = 0; (m < DIM); m++)
-                {
-                    /* if we're computing a full step velocity, v_corrt[d] has v(t).  Otherwise, v(t+dt/2) */
-                    ekin_sum[gt][m][d] += hm*v_corrt[m]*v_corrt[d];
-                }
-            }
-            if (md->nMassPerturbed && md->bPerturbed[n])
-            {
-                *dekindl_sum +=
-                    0.5*(md->massB[n] - md->massA[n])*iprod(v_corrt, v_corrt);
-            }
-        }
+        gmx::runThreadTasks(nthread, [&](int thread)
+                            {
+                                int start_t = ((thread+0)*md->homenr)/nthread;
+                                int end_t   = ((thread+1)*md->homenr)/nthread;
+
+                                clearKineticEnergyWork(ekind, thread);
+                                accumulateKineticEnergy(start_t, end_t, v, md, grpstat,
+                                                        ekind->ekin_work[thread],
+                                                        ekind->dekindl_work[thread]);
+                            });
     }
+    ekind->bEkinhFromUpdate = FALSE;
 
     ekind->dekindl = 0;
     for (thread = 0; thread < nthread; thread++)
@@ -1768,18 +1858,26 @@ void update_pcouple_after_coordinates(FILE             *fplog,
     }
 }
 
+/*! \brief The number of atoms updated at once when accumulating the kinetic energy
+ *
+ * Should be small enough for the velocities of a block to stay in L1 cache
+ * and a multiple of the SIMD width.
+ */
+static constexpr int c_kineticEnergyBlockSize = 256;
+
 void update_coords(int64_t                             step,
                    const t_inputrec                   *inputrec, /* input record and box stuff	*/
                    const t_mdatoms                    *md,
                    t_state                            *state,
                    gmx::ArrayRefWithPadding<gmx::RVec> f,
                    const t_fcdata                     *fcd,
-                   const gmx_ekindata_t               *ekind,
+                   gmx_ekindata_t                     *ekind,
                    const matrix                        M,
                    Update                             *upd,
                    int                                 UpdatePart,
                    const t_commrec                    *cr, /* these shouldn't be here -- need to think about it */
-                   const gmx::Constraints             *constr)
+                   const gmx::Constraints             *constr,
+                   bool                                computeKineticEnergy)
 {
     gmx_bool bDoConstr = (nullptr != constr);
 
@@ -1805,6 +1903,16 @@ void update_coords(int64_t                             step,
         update_orires_history(fcd, &state->hist);
     }
 
+    /* With leap-frog type integrators, velocities are not changed after
+     * the update when we do not have constraints. Then we can accumulate
+     * the half-step kinetic energy here, while the velocities are in cache.
+     */
+    bool accumulateEkinh = (computeKineticEnergy &&
+                            !EI_VV(inputrec->eI) &&
+                            !bDoConstr &&
+                            !ekind->bNEMD &&
+                            ekind->cosacc.cos_accel == 0);
+
     /* ############# START The update of velocities and positions ######### */
     int nth = gmx_omp_nthreads_get(emntUpdate);
 
@@ -1821,86 +1929,106 @@ void update_coords(int64_t                             step,
             rvec       *v_rvec  = state->v.rvec_array();
             const rvec *f_rvec  = as_rvec_array(f.unpaddedArrayRef().data());
 
-            switch (inputrec->eI)
+            if (accumulateEkinh)
             {
-                case (eiMD):
-                    do_update_md(start_th, end_th, step, dt,
-                                 inputrec, md, ekind, state->box,
-                                 x_rvec, xp_rvec, v_rvec, f_rvec,
-                                 state->nosehoover_vxi.data(), M);
-                    break;
-                case (eiSD1):
-                    if (bDoConstr)
-                    {
-                        // With constraints, the SD update is done in 2 parts
-                        doSDUpdateGeneral<SDUpdate::ForcesOnly>
-                            (*upd->sd(),
-                            start_th, end_th, dt,
-                            inputrec->opts.acc, inputrec->opts.nFreeze,
-                            md->invmass, md->ptype,
-                            md->cFREEZE, md->cACC, nullptr,
-                            x_rvec, xp_rvec, v_rvec, f_rvec,
-                            step, inputrec->ld_seed, nullptr);
-                    }
-                    else
-                    {
-                        doSDUpdateGeneral<SDUpdate::Combined>
-                            (*upd->sd(),
-                            start_th, end_th, dt,
-                            inputrec->opts.acc, inputrec->opts.nFreeze,
-                            md->invmass, md->ptype,
-                            md->cFREEZE, md->cACC, md->cTC,
-                            x_rvec, xp_rvec, v_rvec, f_rvec,
-                            step, inputrec->ld_seed,
-                            DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr);
-                    }
-                    break;
-                case (eiBD):
-                    do_update_bd(start_th, end_th, dt,
-                                 inputrec->opts.nFreeze, md->invmass, md->ptype,
-                                 md->cFREEZE, md->cTC,
-                                 x_rvec, xp_rvec, v_rvec, f_rvec,
-                                 inputrec->bd_fric,
-                                 upd->sd()->bd_rf.data(),
-                                 step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr);
-                    break;
-                case (eiVV):
-                case (eiVVAK):
-                {
-                    gmx_bool bExtended = (inputrec->etc == etcNOSEHOOVER ||
-                                          inputrec->epc == epcPARRINELLORAHMAN ||
-                                          inputrec->epc == epcMTTK);
+                clearKineticEnergyWork(ekind, th);
+            }
+
+            /* When accumulating the kinetic energy, we update blocks of atoms */
+            int blockSize = (accumulateEkinh ? c_kineticEnergyBlockSize : end_th - start_th);
+            for (int start_b = start_th; start_b < end_th; start_b += blockSize)
+            {
+                int end_b = std::min(start_b + blockSize, end_th);
 
-                    /* assuming barostat coupled to group 0 */
-                    real alpha = 1.0 + DIM/static_cast<real>(inputrec->opts.nrdf[0]);
-                    switch (UpdatePart)
+                switch (inputrec->eI)
+                {
+                    case (eiMD):
+                        do_update_md(start_b, end_b, step, dt,
+                                     inputrec, md, ekind, state->box,
+                                     x_rvec, xp_rvec, v_rvec, f_rvec,
+                                     state->nosehoover_vxi.data(), M);
+                        break;
+                    case (eiSD1):
+                        if (bDoConstr)
+                        {
+                            // With constraints, the SD update is done in 2 parts
+                            doSDUpdateGeneral<SDUpdate::ForcesOnly>
+                                (*upd->sd(),
+                                start_b, end_b, dt,
+                                inputrec->opts.acc, inputrec->opts.nFreeze,
+                                md->invmass, md->ptype,
+                                md->cFREEZE, md->cACC, nullptr,
+                                x_rvec, xp_rvec, v_rvec, f_rvec,
+                                step, inputrec->ld_seed, nullptr);
+                        }
+                        else
+                        {
+                            doSDUpdateGeneral<SDUpdate::Combined>
+                                (*upd->sd(),
+                                start_b, end_b, dt,
+                                inputrec->opts.acc, inputrec->opts.nFreeze,
+                                md->invmass, md->ptype,
+                                md->cFREEZE, md->cACC, md->cTC,
+                                x_rvec, xp_rvec, v_rvec, f_rvec,
+                                step, inputrec->ld_seed,
+                                DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr);
+                        }
+                        break;
+                    case (eiBD):
+                        do_update_bd(start_b, end_b, dt,
+                                     inputrec->opts.nFreeze, md->invmass, md->ptype,
+                                     md->cFREEZE, md->cTC,
+                                     x_rvec, xp_rvec, v_rvec, f_rvec,
+                                     inputrec->bd_fric,
+                                     upd->sd()->bd_rf.data(),
+                                     step, inputrec->ld_seed, DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr);
+                        break;
+                    case (eiVV):
+                    case (eiVVAK):
                     {
-                        case etrtVELOCITY1:
-                        case etrtVELOCITY2:
-                            do_update_vv_vel(start_th, end_th, dt,
-                                             inputrec->opts.acc, inputrec->opts.nFreeze,
-                                             md->invmass, md->ptype,
-                                             md->cFREEZE, md->cACC,
-                                             v_rvec, f_rvec,
-                                             bExtended, state->veta, alpha);
-                            break;
-                        case etrtPOSITION:
-                            do_update_vv_pos(start_th, end_th, dt,
-                                             inputrec->opts.nFreeze,
-                                             md->ptype, md->cFREEZE,
-                                             x_rvec, xp_rvec, v_rvec,
-                                             bExtended, state->veta);
-                            break;
+                        gmx_bool bExtended = (inputrec->etc == etcNOSEHOOVER ||
+                                              inputrec->epc == epcPARRINELLORAHMAN ||
+                                              inputrec->epc == epcMTTK);
+
+                        /* assuming barostat coupled to group 0 */
+                        real alpha = 1.0 + DIM/static_cast<real>(inputrec->opts.nrdf[0]);
+                        switch (UpdatePart)
+                        {
+                            case etrtVELOCITY1:
+                            case etrtVELOCITY2:
+                                do_update_vv_vel(start_b, end_b, dt,
+                                                 inputrec->opts.acc, inputrec->opts.nFreeze,
+                                                 md->invmass, md->ptype,
+                                                 md->cFREEZE, md->cACC,
+                                                 v_rvec, f_rvec,
+                                                 bExtended, state->veta, alpha);
+                                break;
+                            case etrtPOSITION:
+                                do_update_vv_pos(start_b, end_b, dt,
+                                                 inputrec->opts.nFreeze,
+                                                 md->ptype, md->cFREEZE,
+                                                 x_rvec, xp_rvec, v_rvec,
+                                                 bExtended, state->veta);
+                                break;
+                        }
+                        break;
                     }
-                    break;
+                    default:
+                        gmx_fatal(FARGS, "Don't know how to update coordinates");
+                }
+
+                if (accumulateEkinh)
+                {
+                    accumulateKineticEnergy(start_b, end_b, v_rvec, md, ekind->grpstat,
+                                            ekind->ekin_work[th],
+                                            ekind->dekindl_work[th]);
                 }
-                default:
-                    gmx_fatal(FARGS, "Don't know how to update coordinates");
             }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
 
+    ekind->bEkinhFromUpdate = accumulateEkinh;
 }
 
 extern gmx_bool update_randomize_velocities(const t_inputrec *ir, int64_t step, const t_commrec *cr,
@@ -136,18 +136,24 @@ void update_pcouple_after_coordinates(FILE             *fplog,
                                       t_nrnb           *nrnb,
                                       gmx::Update      *upd);
 
+/* When computeKineticEnergy is set, the half-step kinetic energy is
+ * accumulated in ekind during the update, when the integrator is not
+ * velocity Verlet and no constraints are applied after the update.
+ * The next call to calc_ke_part() then only reduces the result.
+ */
 void update_coords(int64_t                             step,
                    const t_inputrec                   *inputrec, /* input record and box stuff	*/
                    const t_mdatoms                    *md,
                    t_state                            *state,
                    gmx::ArrayRefWithPadding<gmx::RVec> f, /* forces on home particles */
                    const t_fcdata                     *fcd,
-                   const gmx_ekindata_t               *ekind,
+                   gmx_ekindata_t                     *ekind,
                    const matrix                        M,
                    gmx::Update                        *upd,
                    int                                 bUpdatePart,
                    const t_commrec                    *cr, /* these shouldn't be here -- need to think about it */
-                   const gmx::Constraints             *constr);
+                   const gmx::Constraints             *constr,
+                   bool                                computeKineticEnergy = false);
 
 /* Return TRUE if OK, FALSE in case of Shake Error */
 
@@ -39,6 +39,7 @@
 #include "vsite.h"
 
 #include <cstdio>
+#include <cstdlib>
 
 #include <algorithm>
 #include <memory>
@@ -56,6 +57,10 @@
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/mshift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/pbcutil/pbc_simd.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
+#include "gromacs/simd/vector_operations.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/mtop_util.h"
@@ -442,10 +447,333 @@ static PbcMode getPbcMode(const t_pbc *pbcPtr)
     }
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief A batch of GMX_SIMD_REAL_WIDTH vsites of the same type in SoA layout */
+struct VsiteBatchSimd
+{
+    //! The vsite atoms
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t av[GMX_SIMD_REAL_WIDTH];
+    //! The first constructing atoms
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    //! The second constructing atoms
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    //! The third constructing atoms, only used for three-atom constructions
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    //! The first construction parameters
+    alignas(GMX_SIMD_ALIGNMENT) real         a[GMX_SIMD_REAL_WIDTH];
+    //! The second construction parameters, only used for three-atom constructions
+    alignas(GMX_SIMD_ALIGNMENT) real         b[GMX_SIMD_REAL_WIDTH];
+};
+
+/*! \brief Returns the number of constructing atoms for the vsite types with SIMD kernels */
+static constexpr int vsiteSimdNumConstructingAtoms(int ftype)
+{
+    return (ftype == F_VSITE2 ? 2 : 3);
+}
+
+/*! \brief Loads the atom indices and parameters of GMX_SIMD_REAL_WIDTH vsites of type \p ftype
+ *
+ * \param[in]  ia     The interaction list entries of the batch
+ * \param[in]  ip     Interaction parameters
+ * \param[out] batch  The batch
+ */
+template <int ftype>
+static void loadVsiteBatch(const t_iatom   *ia,
+                           const t_iparams  ip[],
+                           VsiteBatchSimd  *batch)
+{
+    constexpr int numConstructingAtoms = vsiteSimdNumConstructingAtoms(ftype);
+
+    for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+    {
+        const t_iparams &params = ip[ia[0]];
+
+        batch->av[s] = ia[1];
+        batch->ai[s] = ia[2];
+        batch->aj[s] = ia[3];
+        batch->a[s]  = params.vsite.a;
+        if (numConstructingAtoms == 3)
+        {
+            batch->ak[s] = ia[4];
+            batch->b[s]  = params.vsite.b;
+        }
+
+        ia += 2 + numConstructingAtoms;
+    }
+}
+
+/*! \brief Returns the distance vector dx = x2 - x1, corrected for PBC when \p pbc_simd != nullptr */
+static inline void vsiteDxSimd(gmx::SimdReal x1, gmx::SimdReal y1, gmx::SimdReal z1,
+                               gmx::SimdReal x2, gmx::SimdReal y2, gmx::SimdReal z2,
+                               const real *pbc_simd,
+                               gmx::SimdReal *dx, gmx::SimdReal *dy, gmx::SimdReal *dz)
+{
+    *dx = x2 - x1;
+    *dy = y2 - y1;
+    *dz = z2 - z1;
+    if (pbc_simd != nullptr)
+    {
+        pbc_correct_dx_simd(dx, dy, dz, pbc_simd);
+    }
+}
+
+/*! \brief Constructs full SIMD batches of vsites of type \p ftype
+ *
+ * The vsites of one batch are constructed simultaneously, so they should
+ * not be constructed from vsites in the same list.
+ *
+ * \param[in,out] x         The coordinates, should be padded for SIMD loads
+ * \param[in]     inv_dt    The inverse time step
+ * \param[out]    v         When != nullptr, the vsite velocities are set
+ * \param[in]     ip        Interaction parameters
+ * \param[in]     ilist     The interaction list for type \p ftype
+ * \param[in]     pbc_simd  The PBC data for SIMD, nullptr when no PBC is needed
+ * \returns the number of entries in \p ilist that have been processed
+ */
+template <int ftype>
+static int constructVsitesSimd(rvec             x[],
+                               real             inv_dt,
+                               rvec            *v,
+                               const t_iparams  ip[],
+                               const t_ilist   &ilist,
+                               const real      *pbc_simd)
+{
+    using namespace gmx;
+
+    constexpr int batchSize  = (2 + vsiteSimdNumConstructingAtoms(ftype))*GMX_SIMD_REAL_WIDTH;
+    const int     numEntries = (ilist.nr/batchSize)*batchSize;
+
+    real         *xPtr       = x[0];
+    VsiteBatchSimd batch;
+
+    for (int i = 0; i < numEntries; i += batchSize)
+    {
+        loadVsiteBatch<ftype>(ilist.iatoms + i, ip, &batch);
+
+        SimdReal xi, yi, zi, xj, yj, zj;
+        gatherLoadUTranspose<3>(xPtr, batch.ai, &xi, &yi, &zi);
+        gatherLoadUTranspose<3>(xPtr, batch.aj, &xj, &yj, &zj);
+        const SimdReal a = load<SimdReal>(batch.a);
+
+        SimdReal       xv, yv, zv;
+        if (ftype == F_VSITE2)
+        {
+            SimdReal dxj, dyj, dzj;
+            vsiteDxSimd(xi, yi, zi, xj, yj, zj, pbc_simd, &dxj, &dyj, &dzj);
+            xv = fma(a, dxj, xi);
+            yv = fma(a, dyj, yi);
+            zv = fma(a, dzj, zi);
+        }
+        else
+        {
+            SimdReal xk, yk, zk;
+            gatherLoadUTranspose<3>(xPtr, batch.ak, &xk, &yk, &zk);
+            const SimdReal b = load<SimdReal>(batch.b);
+
+            if (ftype == F_VSITE3)
+            {
+                SimdReal dxj, dyj, dzj, dxk, dyk, dzk;
+                vsiteDxSimd(xi, yi, zi, xj, yj, zj, pbc_simd, &dxj, &dyj, &dzj);
+                vsiteDxSimd(xi, yi, zi, xk, yk, zk, pbc_simd, &dxk, &dyk, &dzk);
+                xv = fma(b, dxk, fma(a, dxj, xi));
+                yv = fma(b, dyk, fma(a, dyj, yi));
+                zv = fma(b, dzk, fma(a, dzj, zi));
+            }
+            else
+            {
+                /* F_VSITE3FD */
+                SimdReal xij, yij, zij, xjk, yjk, zjk;
+                vsiteDxSimd(xi, yi, zi, xj, yj, zj, pbc_simd, &xij, &yij, &zij);
+                vsiteDxSimd(xj, yj, zj, xk, yk, zk, pbc_simd, &xjk, &yjk, &zjk);
+
+                /* temp goes from i to a point on the line jk */
+                const SimdReal tempx = fma(a, xjk, xij);
+                const SimdReal tempy = fma(a, yjk, yij);
+                const SimdReal tempz = fma(a, zjk, zij);
+                const SimdReal c     = b*invsqrt(norm2(tempx, tempy, tempz));
+
+                xv = fma(c, tempx, xi);
+                yv = fma(c, tempy, yi);
+                zv = fma(c, tempz, zi);
+            }
+        }
+
+        if (pbc_simd != nullptr || v != nullptr)
+        {
+            /* Keep the vsite in the same periodic image as before */
+            SimdReal xOld, yOld, zOld, dx, dy, dz;
+            gatherLoadUTranspose<3>(xPtr, batch.av, &xOld, &yOld, &zOld);
+            vsiteDxSimd(xOld, yOld, zOld, xv, yv, zv, pbc_simd, &dx, &dy, &dz);
+            if (pbc_simd != nullptr)
+            {
+                xv = xOld + dx;
+                yv = yOld + dy;
+                zv = zOld + dz;
+            }
+            if (v != nullptr)
+            {
+                transposeScatterStoreU<3>(v[0], batch.av, dx*inv_dt, dy*inv_dt, dz*inv_dt);
+            }
+        }
+
+        transposeScatterStoreU<3>(xPtr, batch.av, xv, yv, zv);
+    }
+
+    return numEntries;
+}
+
+/*! \brief Spreads the forces of full SIMD batches of vsites of type \p ftype
+ *
+ * Shift forces are not computed, so this should only be called when
+ * no shift forces are needed or all shifts are zero.
+ * The vsites of one batch are spread simultaneously, so they should
+ * not be constructed from vsites in the same list.
+ *
+ * \param[in]     x         The coordinates, should be padded for SIMD loads
+ * \param[in,out] f         The forces, should be padded for SIMD loads
+ * \param[in]     VirCorr   Whether to compute the virial correction
+ * \param[in,out] dxdf      The virial correction accumulation buffer
+ * \param[in]     ip        Interaction parameters
+ * \param[in]     ilist     The interaction list for type \p ftype
+ * \param[in]     pbc_simd  The PBC data for SIMD, nullptr when no PBC is needed
+ * \returns the number of entries in \p ilist that have been processed
+ */
+template <int ftype>
+static int spreadVsitesSimd(const rvec       x[],
+                            rvec             f[],
+                            gmx_bool         VirCorr,
+                            matrix           dxdf,
+                            const t_iparams  ip[],
+                            const t_ilist   &ilist,
+                            const real      *pbc_simd)
+{
+    using namespace gmx;
+
+    constexpr int  batchSize  = (2 + vsiteSimdNumConstructingAtoms(ftype))*GMX_SIMD_REAL_WIDTH;
+    const int      numEntries = (ilist.nr/batchSize)*batchSize;
+
+    const real    *xPtr       = x[0];
+    real          *fPtr       = f[0];
+    const SimdReal zero       = setZero();
+    const SimdReal one(1.0);
+    VsiteBatchSimd batch;
+
+    /* Virial correction accumulators for F_VSITE3FD */
+    SimdReal       dxdfS[DIM][DIM];
+    for (int d1 = 0; d1 < DIM; d1++)
+    {
+        for (int d2 = 0; d2 < DIM; d2++)
+        {
+            dxdfS[d1][d2] = zero;
+        }
+    }
+
+    for (int i = 0; i < numEntries; i += batchSize)
+    {
+        loadVsiteBatch<ftype>(ilist.iatoms + i, ip, &batch);
+
+        SimdReal fvx, fvy, fvz;
+        gatherLoadUTranspose<3>(fPtr, batch.av, &fvx, &fvy, &fvz);
+        const SimdReal a = load<SimdReal>(batch.a);
+
+        if (ftype == F_VSITE2)
+        {
+            const SimdReal fjx = a*fvx;
+            const SimdReal fjy = a*fvy;
+            const SimdReal fjz = a*fvz;
+            transposeScatterIncrU<3>(fPtr, batch.ai, fvx - fjx, fvy - fjy, fvz - fjz);
+            transposeScatterIncrU<3>(fPtr, batch.aj, fjx, fjy, fjz);
+        }
+        else if (ftype == F_VSITE3)
+        {
+            const SimdReal b   = load<SimdReal>(batch.b);
+            const SimdReal fjx = a*fvx;
+            const SimdReal fjy = a*fvy;
+            const SimdReal fjz = a*fvz;
+            const SimdReal fkx = b*fvx;
+            const SimdReal fky = b*fvy;
+            const SimdReal fkz = b*fvz;
+            transposeScatterIncrU<3>(fPtr, batch.ai, fvx - fjx - fkx, fvy - fjy - fky, fvz - fjz - fkz);
+            transposeScatterIncrU<3>(fPtr, batch.aj, fjx, fjy, fjz);
+            transposeScatterIncrU<3>(fPtr, batch.ak, fkx, fky, fkz);
+        }
+        else
+        {
+            /* F_VSITE3FD */
+            const SimdReal b = load<SimdReal>(batch.b);
+
+            SimdReal       xi, yi, zi, xj, yj, zj, xk, yk, zk;
+            gatherLoadUTranspose<3>(xPtr, batch.ai, &xi, &yi, &zi);
+            gatherLoadUTranspose<3>(xPtr, batch.aj, &xj, &yj, &zj);
+            gatherLoadUTranspose<3>(xPtr, batch.ak, &xk, &yk, &zk);
+
+            SimdReal xij, yij, zij, xjk, yjk, zjk;
+            vsiteDxSimd(xi, yi, zi, xj, yj, zj, pbc_simd, &xij, &yij, &zij);
+            vsiteDxSimd(xj, yj, zj, xk, yk, zk, pbc_simd, &xjk, &yjk, &zjk);
+
+            /* xix goes from i to point x on the line jk */
+            const SimdReal xix   = fma(a, xjk, xij);
+            const SimdReal yix   = fma(a, yjk, yij);
+            const SimdReal zix   = fma(a, zjk, zij);
+
+            const SimdReal invl  = invsqrt(norm2(xix, yix, zix));
+            const SimdReal c     = b*invl;
+            const SimdReal fproj = iprod(xix, yix, zix, fvx, fvy, fvz)*invl*invl;
+
+            const SimdReal tempx = c*fnma(fproj, xix, fvx);
+            const SimdReal tempy = c*fnma(fproj, yix, fvy);
+            const SimdReal tempz = c*fnma(fproj, zix, fvz);
+
+            const SimdReal a1    = one - a;
+            transposeScatterIncrU<3>(fPtr, batch.ai, fvx - tempx, fvy - tempy, fvz - tempz);
+            transposeScatterIncrU<3>(fPtr, batch.aj, a1*tempx, a1*tempy, a1*tempz);
+            transposeScatterIncrU<3>(fPtr, batch.ak, a*tempx, a*tempy, a*tempz);
+
+            if (VirCorr)
+            {
+                /* See spread_vsite3FD for the virial correction */
+                SimdReal xv, yv, zv, xiv[DIM];
+                gatherLoadUTranspose<3>(xPtr, batch.av, &xv, &yv, &zv);
+                vsiteDxSimd(xi, yi, zi, xv, yv, zv, pbc_simd, &xiv[XX], &xiv[YY], &xiv[ZZ]);
+
+                const SimdReal xixS[DIM]  = { xix, yix, zix };
+                const SimdReal fvS[DIM]   = { fvx, fvy, fvz };
+                const SimdReal tempS[DIM] = { tempx, tempy, tempz };
+                for (int d1 = 0; d1 < DIM; d1++)
+                {
+                    for (int d2 = 0; d2 < DIM; d2++)
+                    {
+                        dxdfS[d1][d2] = fma(xixS[d1], tempS[d2], fnma(xiv[d1], fvS[d2], dxdfS[d1][d2]));
+                    }
+                }
+            }
+        }
+
+        transposeScatterStoreU<3>(fPtr, batch.av, zero, zero, zero);
+    }
+
+    if (ftype == F_VSITE3FD && VirCorr)
+    {
+        for (int d1 = 0; d1 < DIM; d1++)
+        {
+            for (int d2 = 0; d2 < DIM; d2++)
+            {
+                dxdf[d1][d2] += reduce(dxdfS[d1][d2]);
+            }
+        }
+    }
+
+    return numEntries;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 static void construct_vsites_thread(rvec x[],
                                     real dt, rvec *v,
                                     const t_iparams ip[], const t_ilist ilist[],
-                                    const t_pbc *pbc_null)
+                                    const t_pbc *pbc_null,
+                                    bool gmx_unused useSimd)
 {
     real         inv_dt;
     if (v != nullptr)
@@ -461,6 +789,15 @@ static void construct_vsites_thread(rvec x[],
     /* We need another pbc pointer, as with charge groups we switch per vsite */
     const t_pbc             *pbc_null2 = pbc_null;
 
+#if GMX_SIMD_HAVE_REAL
+    alignas(GMX_SIMD_ALIGNMENT) real pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+    if (useSimd && pbc_null != nullptr)
+    {
+        set_pbc_simd(pbc_null, pbc_simd);
+    }
+    const real *pbcSimdPtr = (pbc_null != nullptr ? pbc_simd : nullptr);
+#endif
+
     for (int ftype = c_ftypeVsiteStart; ftype < c_ftypeVsiteEnd; ftype++)
     {
         if (ilist[ftype].nr == 0)
@@ -475,7 +812,30 @@ static void construct_vsites_thread(rvec x[],
 
             const t_iatom *ia = ilist[ftype].iatoms;
 
-            for (int i = 0; i < nr; )
+            /* Construct the full SIMD batches first, the rest below */
+            int            i   = 0;
+#if GMX_SIMD_HAVE_REAL
+            if (useSimd)
+            {
+                switch (ftype)
+                {
+                    case F_VSITE2:
+                        i = constructVsitesSimd<F_VSITE2>(x, inv_dt, v, ip, ilist[ftype], pbcSimdPtr);
+                        break;
+                    case F_VSITE3:
+                        i = constructVsitesSimd<F_VSITE3>(x, inv_dt, v, ip, ilist[ftype], pbcSimdPtr);
+                        break;
+                    case F_VSITE3FD:
+                        i = constructVsitesSimd<F_VSITE3FD>(x, inv_dt, v, ip, ilist[ftype], pbcSimdPtr);
+                        break;
+                    default:
+                        break;
+                }
+                ia += i;
+            }
+#endif
+
+            while (i < nr)
             {
                 int  tp     = ia[0];
                 /* The vsite and constructing atoms */
@@ -615,11 +975,14 @@ void construct_vsites(const gmx_vsite_t *vsite,
         dd_move_x_vsites(cr->dd, box, x);
     }
 
+    /* Without a vsite struct we do not know if we can use SIMD */
+    const bool useSimd = (vsite != nullptr && vsite->useSimd);
+
     if (vsite == nullptr || vsite->nthreads == 1)
     {
         construct_vsites_thread(x, dt, v,
                                 ip, ilist,
-                                pbc_null);
+                                pbc_null, useSimd);
     }
     else
     {
@@ -633,7 +996,7 @@ void construct_vsites(const gmx_vsite_t *vsite,
 
                 construct_vsites_thread(x, dt, v,
                                         ip, tData.ilist,
-                                        pbc_null);
+                                        pbc_null, useSimd);
                 if (tData.useInterdependentTask)
                 {
                     /* Here we don't need a barrier (unlike the spreading),
@@ -642,7 +1005,7 @@ void construct_vsites(const gmx_vsite_t *vsite,
                      */
                     construct_vsites_thread(x, dt, v,
                                             ip, tData.idTask.ilist,
-                                            pbc_null);
+                                            pbc_null, useSimd);
                 }
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
@@ -650,7 +1013,7 @@ void construct_vsites(const gmx_vsite_t *vsite,
         /* Now we can construct the vsites that might depend on other vsites */
         construct_vsites_thread(x, dt, v,
                                 ip, vsite->tData[vsite->nthreads]->ilist,
-                                pbc_null);
+                                pbc_null, useSimd);
     }
 }
 
@@ -1441,13 +1804,27 @@ static void spread_vsite_f_thread(const rvec x[],
                                   rvec f[], rvec *fshift,
                                   gmx_bool VirCorr, matrix dxdf,
                                   t_iparams ip[], const t_ilist ilist[],
-                                  const t_graph *g, const t_pbc *pbc_null)
+                                  const t_graph *g, const t_pbc *pbc_null,
+                                  bool useSimd)
 {
     const PbcMode            pbcMode   = getPbcMode(pbc_null);
     /* We need another pbc pointer, as with charge groups we switch per vsite */
     const t_pbc             *pbc_null2 = pbc_null;
     gmx::ArrayRef<const int> vsite_pbc;
 
+    /* The SIMD kernels do not compute shift forces, which are only
+     * non-zero with a graph or with PBC.
+     */
+    useSimd = useSimd && g == nullptr && (fshift == nullptr || pbc_null == nullptr);
+#if GMX_SIMD_HAVE_REAL
+    alignas(GMX_SIMD_ALIGNMENT) real pbc_simd[9*GMX_SIMD_REAL_WIDTH];
+    if (useSimd && pbc_null != nullptr)
+    {
+        set_pbc_simd(pbc_null, pbc_simd);
+    }
+    const real *pbcSimdPtr = (pbc_null != nullptr ? pbc_simd : nullptr);
+#endif
+
     /* this loop goes backwards to be able to build *
      * higher type vsites from lower types         */
     for (int ftype = c_ftypeVsiteEnd - 1; ftype >= c_ftypeVsiteStart; ftype--)
@@ -1469,7 +1846,30 @@ static void spread_vsite_f_thread(const rvec x[],
                 pbc_null2 = pbc_null;
             }
 
-            for (int i = 0; i < nr; )
+            /* Spread the full SIMD batches first, the rest below */
+            int            i   = 0;
+#if GMX_SIMD_HAVE_REAL
+            if (useSimd)
+            {
+                switch (ftype)
+                {
+                    case F_VSITE2:
+                        i = spreadVsitesSimd<F_VSITE2>(x, f, VirCorr, dxdf, ip, ilist[ftype], pbcSimdPtr);
+                        break;
+                    case F_VSITE3:
+                        i = spreadVsitesSimd<F_VSITE3>(x, f, VirCorr, dxdf, ip, ilist[ftype], pbcSimdPtr);
+                        break;
+                    case F_VSITE3FD:
+                        i = spreadVsitesSimd<F_VSITE3FD>(x, f, VirCorr, dxdf, ip, ilist[ftype], pbcSimdPtr);
+                        break;
+                    default:
+                        break;
+                }
+                ia += i;
+            }
+#endif
+
+            while (i < nr)
             {
                 int tp = ia[0];
 
@@ -1584,7 +1984,7 @@ void spread_vsite_f(const gmx_vsite_t *vsite,
         spread_vsite_f_thread(x, f, fshift,
                               VirCorr, dxdf,
                               idef->iparams, idef->il,
-                              g, pbc_null);
+                              g, pbc_null, vsite->useSimd);
 
         if (VirCorr)
         {
@@ -1608,7 +2008,7 @@ void spread_vsite_f(const gmx_vsite_t *vsite,
                               VirCorr, vsite->tData[vsite->nthreads]->dxdf,
                               idef->iparams,
                               vsite->tData[vsite->nthreads]->ilist,
-                              g, pbc_null);
+                              g, pbc_null, vsite->useSimd);
 
 #pragma omp parallel num_threads(vsite->nthreads)
         {
@@ -1659,7 +2059,7 @@ void spread_vsite_f(const gmx_vsite_t *vsite,
                                           VirCorr, tData.dxdf,
                                           idef->iparams,
                                           tData.idTask.ilist,
-                                          g, pbc_null);
+                                          g, pbc_null, vsite->useSimd);
 
                     /* We need a barrier before reducing forces below
                      * that have been produced by a different thread above.
@@ -1700,7 +2100,7 @@ void spread_vsite_f(const gmx_vsite_t *vsite,
                                       VirCorr, tData.dxdf,
                                       idef->iparams,
                                       tData.ilist,
-                                      g, pbc_null);
+                                      g, pbc_null, vsite->useSimd);
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
         }
@@ -1834,6 +2234,47 @@ int countInterUpdategroupVsites(const gmx_mtop_t                            &mto
     return n_intercg_vsite;
 }
 
+/*! \brief Returns whether any vsite is constructed from a vsite of the same type
+ *
+ * Such vsites can not be processed in SIMD batches, since all vsites
+ * in a batch are constructed and spread simultaneously.
+ *
+ * \param[in] mtop  The global topology
+ */
+static bool haveVsitesConstructedFromSameType(const gmx_mtop_t &mtop)
+{
+    for (const gmx_moltype_t &molt : mtop.moltype)
+    {
+        std::vector<int> vsiteType(molt.atoms.nr, -1);
+        for (int ftype = c_ftypeVsiteStart; ftype < c_ftypeVsiteEnd; ftype++)
+        {
+            const InteractionList &il  = molt.ilist[ftype];
+            const int              inc = 1 + NRAL(ftype);
+            for (int i = 0; i < il.size(); i += inc)
+            {
+                vsiteType[il.iatoms[i + 1]] = ftype;
+            }
+        }
+        for (int ftype = c_ftypeVsiteStart; ftype < c_ftypeVsiteEnd; ftype++)
+        {
+            const InteractionList &il  = molt.ilist[ftype];
+            const int              inc = 1 + NRAL(ftype);
+            for (int i = 0; i < il.size(); i += inc)
+            {
+                for (int a = 2; a < inc; a++)
+                {
+                    if (vsiteType[il.iatoms[i + a]] == ftype)
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
 std::unique_ptr<gmx_vsite_t>
 initVsite(const gmx_mtop_t &mtop,
           const t_commrec  *cr)
@@ -1874,6 +2315,10 @@ initVsite(const gmx_mtop_t &mtop,
 
     vsite->useDomdec                 = (DOMAINDECOMP(cr) && cr->dd->nnodes > 1);
 
+    vsite->useSimd                   = (GMX_SIMD_HAVE_REAL &&
+                                        getenv("GMX_DISABLE_SIMD_KERNELS") == nullptr &&
+                                        !haveVsitesConstructedFromSameType(mtop));
+
     vsite->nthreads                  = gmx_omp_nthreads_get(emntVSITE);
 
     if (vsite->nthreads > 1)
@@ -2285,10 +2730,11 @@ void split_vsites_over_threads(const t_ilist   *ilist,
                 /* To avoid resizing and re-clearing every nstlist steps,
                  * we never down size the force buffer.
                  */
-                if (natoms_use_in_vsites > idTask.force.size() ||
+                if (natoms_use_in_vsites + 1 > idTask.force.size() ||
                     natoms_use_in_vsites > idTask.use.size())
                 {
-                    idTask.force.resize(natoms_use_in_vsites, { 0, 0, 0 });
+                    /* One extra element for padding for SIMD loads */
+                    idTask.force.resize(natoms_use_in_vsites + 1, { 0, 0, 0 });
                     idTask.use.resize(natoms_use_in_vsites, false);
                 }
             }
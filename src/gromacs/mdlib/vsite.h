@@ -85,6 +85,7 @@ struct gmx_vsite_t
     std::vector < std::unique_ptr < VsiteThread>> tData; /* Thread local vsites and work structs    */
     std::vector<int>          taskIndex;                 /* Work array                              */
     bool                      useDomdec;                 /* Tells whether we use domain decomposition with more than 1 DD rank */
+    bool                      useSimd;                   /* Tells whether vsites can be constructed and spread in SIMD batches */
 };
 
 /*! \brief Create positions of vsite atoms based for the local system
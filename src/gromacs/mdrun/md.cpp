@@ -118,6 +118,7 @@
 #include "gromacs/mdtypes/pullhistory.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/pairlist_tuning.h"
 #include "gromacs/pbcutil/mshift.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pulling/output.h"
@@ -433,6 +434,10 @@ void gmx::Simulator::do_md()
                          &bPMETunePrinting);
     }
 
+    /* Tuning of the dynamic pruning interval requires one force call per step */
+    DynamicPruningTuner dynamicPruningTuner(*fr->nbv,
+                                            !mdrunOptions.reproducible && shellfc == nullptr);
+
     if (!ir->bContinuation)
     {
         if (state->flags & (1 << estV))
@@ -734,6 +739,14 @@ void gmx::Simulator::do_md()
                            &bPMETunePrinting);
         }
 
+        /* Tune the dynamic pruning after PME tuning, which changes the cut-off's */
+        if (dynamicPruningTuner.isActive() && bNStList &&
+            !pme_loadbal_is_active(pme_loadbal))
+        {
+            dynamicPruningTuner.tune(mdlog, *ir, *top_global, state->box, *fr->ic,
+                                     wcycle, fr->nbv.get());
+        }
+
         wallcycle_start(wcycle, ewcSTEP);
 
         bLastStep = (step_rel == ir->nsteps);
@@ -872,6 +885,15 @@ void gmx::Simulator::do_md()
                   do_per_step(step, nstglobalcomm) ||
                   (EI_VV(ir->eI) && inputrecNvtTrotter(ir) && do_per_step(step-1, nstglobalcomm)));
 
+        // Organize to do inter-simulation signalling on steps if
+        // and when algorithms require it.
+        const bool doInterSimSignal = (simulationsShareState && do_per_step(step, nstSignalComm));
+
+        /* Do we call compute_globals after the update? Then the update can
+         * already accumulate the kinetic energy.
+         */
+        const bool bComputeGlobals = (bGStat || (!EI_VV(ir->eI) && do_per_step(step+1, nstglobalcomm)) || doInterSimSignal);
+
         force_flags = (GMX_FORCE_STATECHANGED |
                        ((inputrecDynamicBox(ir)) ? GMX_FORCE_DYNAMICBOX : 0) |
                        GMX_FORCE_ALLFORCES |
@@ -1207,7 +1229,8 @@ void gmx::Simulator::do_md()
         else
         {
             update_coords(step, ir, mdatoms, state, f.arrayRefWithPadding(), fcd,
-                          ekind, M, &upd, etrtPOSITION, cr, constr);
+                          ekind, M, &upd, etrtPOSITION, cr, constr,
+                          !EI_VV(ir->eI) && bComputeGlobals);
 
             wallcycle_stop(wcycle, ewcUPDATE);
 
@@ -1302,40 +1325,34 @@ void gmx::Simulator::do_md()
          * non-communication steps, but we need to calculate
          * the kinetic energy one step before communication.
          */
-        {
-            // Organize to do inter-simulation signalling on steps if
-            // and when algorithms require it.
-            bool doInterSimSignal = (simulationsShareState && do_per_step(step, nstSignalComm));
-
-            if (bGStat || (!EI_VV(ir->eI) && do_per_step(step+1, nstglobalcomm)) || doInterSimSignal)
-            {
-                // Since we're already communicating at this step, we
-                // can propagate intra-simulation signals. Note that
-                // check_nstglobalcomm has the responsibility for
-                // choosing the value of nstglobalcomm that is one way
-                // bGStat becomes true, so we can't get into a
-                // situation where e.g. checkpointing can't be
-                // signalled.
-                bool                doIntraSimSignal = true;
-                SimulationSignaller signaller(&signals, cr, ms, doInterSimSignal, doIntraSimSignal);
+        if (bComputeGlobals)
+        {
+            // Since we're already communicating at this step, we
+            // can propagate intra-simulation signals. Note that
+            // check_nstglobalcomm has the responsibility for
+            // choosing the value of nstglobalcomm that is one way
+            // bGStat becomes true, so we can't get into a
+            // situation where e.g. checkpointing can't be
+            // signalled.
+            bool                doIntraSimSignal = true;
+            SimulationSignaller signaller(&signals, cr, ms, doInterSimSignal, doIntraSimSignal);
 
-                compute_globals(fplog, gstat, cr, ir, fr, ekind, state, mdatoms, nrnb, &vcm,
-                                wcycle, enerd, force_vir, shake_vir, total_vir, pres, mu_tot,
-                                constr, &signaller,
-                                lastbox,
-                                &totalNumberOfBondedInteractions, &bSumEkinhOld,
-                                (bGStat ? CGLO_GSTAT : 0)
-                                | (!EI_VV(ir->eI) && bCalcEner ? CGLO_ENERGY : 0)
-                                | (!EI_VV(ir->eI) && bStopCM ? CGLO_STOPCM : 0)
-                                | (!EI_VV(ir->eI) ? CGLO_TEMPERATURE : 0)
-                                | (!EI_VV(ir->eI) ? CGLO_PRESSURE : 0)
-                                | CGLO_CONSTRAINT
-                                | (shouldCheckNumberOfBondedInteractions ? CGLO_CHECK_NUMBER_OF_BONDED_INTERACTIONS : 0)
-                                );
-                checkNumberOfBondedInteractions(mdlog, cr, totalNumberOfBondedInteractions,
-                                                top_global, &top, state,
-                                                &shouldCheckNumberOfBondedInteractions);
-            }
+            compute_globals(fplog, gstat, cr, ir, fr, ekind, state, mdatoms, nrnb, &vcm,
+                            wcycle, enerd, force_vir, shake_vir, total_vir, pres, mu_tot,
+                            constr, &signaller,
+                            lastbox,
+                            &totalNumberOfBondedInteractions, &bSumEkinhOld,
+                            (bGStat ? CGLO_GSTAT : 0)
+                            | (!EI_VV(ir->eI) && bCalcEner ? CGLO_ENERGY : 0)
+                            | (!EI_VV(ir->eI) && bStopCM ? CGLO_STOPCM : 0)
+                            | (!EI_VV(ir->eI) ? CGLO_TEMPERATURE : 0)
+                            | (!EI_VV(ir->eI) ? CGLO_PRESSURE : 0)
+                            | CGLO_CONSTRAINT
+                            | (shouldCheckNumberOfBondedInteractions ? CGLO_CHECK_NUMBER_OF_BONDED_INTERACTIONS : 0)
+                            );
+            checkNumberOfBondedInteractions(mdlog, cr, totalNumberOfBondedInteractions,
+                                            top_global, &top, state,
+                                            &shouldCheckNumberOfBondedInteractions);
         }
 
         /* #############  END CALC EKIN AND PRESSURE ################# */
@@ -98,6 +98,7 @@
 #include "gromacs/mdlib/qmmm.h"
 #include "gromacs/mdlib/sighandler.h"
 #include "gromacs/mdlib/stophandler.h"
+#include "gromacs/mdlib/threadteam.h"
 #include "gromacs/mdrun/mdmodules.h"
 #include "gromacs/mdrun/simulationcontext.h"
 #include "gromacs/mdrunutility/handlerestart.h"
@@ -289,8 +290,11 @@ static void prepare_verlet_scheme(FILE                           *fplog,
         ListSetupType      listType  = (makeGpuPairList ? ListSetupType::Gpu : ListSetupType::CpuSimdWhenSupported);
         VerletbufListSetup listSetup = verletbufGetSafeListSetup(listType);
 
+        /* The thread counts are not set yet and every thread-MPI rank
+         * calls this, so we estimate the buffer serially.
+         */
         const real         rlist_new =
-            calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1, -1, listSetup);
+            calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1, -1, listSetup, 1);
 
         if (rlist_new != ir->rlist)
         {
@@ -1216,6 +1220,10 @@ int Mdrunner::mdrunner()
             appendText("The -resetstep functionality is deprecated, and may be removed in a future version.");
     }
     wcycle = wallcycle_init(fplog, mdrunOptions.timingOptions.resetStep, cr);
+    if (gmx::ThreadTeam *threadTeam = gmx_omp_nthreads_get_thread_team())
+    {
+        threadTeam->setWallcycle(wcycle);
+    }
 
     if (PAR(cr))
     {
@@ -1509,6 +1517,10 @@ int Mdrunner::mdrunner()
                EI_DYNAMICS(inputrec->eI) && !isMultiSim(ms));
 
     // clean up cycle counter
+    if (gmx::ThreadTeam *threadTeam = gmx_omp_nthreads_get_thread_team())
+    {
+        threadTeam->setWallcycle(nullptr);
+    }
     wallcycle_destroy(wcycle);
 
 // Free PME data
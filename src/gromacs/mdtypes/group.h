@@ -78,6 +78,7 @@ struct gmx_ekindata_t {
     tensor                  **ekin_work_alloc; /* Allocated locations for *_work members */
     tensor                  **ekin_work;       /* Work arrays for tcstat per thread    */
     real                    **dekindl_work;    /* Work location for dekindl per thread */
+    gmx_bool                  bEkinhFromUpdate; /* ekinh is in *_work, accumulated by the update */
     int                       ngacc;           /* The number of acceleration groups    */
     std::vector<t_grp_acc>    grpstat;         /* Acceleration data			*/
     tensor                    ekin;            /* overall kinetic energy               */
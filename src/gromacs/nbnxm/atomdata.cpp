@@ -50,6 +50,7 @@
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdlib/threadteam.h"
 #include "gromacs/mdtypes/forcerec.h" // only for GET_CGINFO_*
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/nbnxm/nbnxm.h"
@@ -129,6 +130,59 @@ static void copy_int_to_nbat_int(const int *a, int na, int na_round,
     }
 }
 
+/* Copies and reorders the coordinates of na atoms with indices a into
+ * the X4 or X8 layout, given by packSize, starting at atom a0 in xnb.
+ * Locations na to na_round are filled with fillValue.
+ * Apart from partial packs at the start and end, complete packs are gathered
+ * and transposed at once, which avoids the per-atom pack boundary checks
+ * and lets the compiler vectorize the stores.
+ */
+template<int packSize>
+static void copy_rvec_to_nbat_real_packed(const int *a, int na, int na_round,
+                                          const rvec *x, real *xnb, int a0,
+                                          real fillValue)
+{
+    int i    = 0;
+    int atom = a0;
+
+    /* Copy the atoms up to the first pack boundary one by one */
+    for (; i < na && (atom & (packSize - 1)) != 0; i++, atom++)
+    {
+        const int j = atom_to_x_index<packSize>(atom);
+        xnb[j + XX*packSize] = x[a[i]][XX];
+        xnb[j + YY*packSize] = x[a[i]][YY];
+        xnb[j + ZZ*packSize] = x[a[i]][ZZ];
+    }
+    /* Gather and transpose complete packs */
+    for (; i + packSize <= na; i += packSize, atom += packSize)
+    {
+        real * gmx_restrict xp = xnb + atom_to_x_index<packSize>(atom);
+        for (int k = 0; k < packSize; k++)
+        {
+            const real *xk        = x[a[i + k]];
+            xp[XX*packSize + k]   = xk[XX];
+            xp[YY*packSize + k]   = xk[YY];
+            xp[ZZ*packSize + k]   = xk[ZZ];
+        }
+    }
+    /* Copy the remaining atoms one by one */
+    for (; i < na; i++, atom++)
+    {
+        const int j = atom_to_x_index<packSize>(atom);
+        xnb[j + XX*packSize] = x[a[i]][XX];
+        xnb[j + YY*packSize] = x[a[i]][YY];
+        xnb[j + ZZ*packSize] = x[a[i]][ZZ];
+    }
+    /* Complete the partially filled last cell with fillValue */
+    for (; i < na_round; i++, atom++)
+    {
+        const int j = atom_to_x_index<packSize>(atom);
+        xnb[j + XX*packSize] = fillValue;
+        xnb[j + YY*packSize] = fillValue;
+        xnb[j + ZZ*packSize] = fillValue;
+    }
+}
+
 void copy_rvec_to_nbat_real(const int *a, int na, int na_round,
                             const rvec *x, int nbatFormat,
                             real *xnb, int a0)
@@ -145,7 +199,7 @@ void copy_rvec_to_nbat_real(const int *a, int na, int na_round,
      */
     const real farAway = -1000000;
 
-    int        i, j, c;
+    int        i, j;
 
     switch (nbatFormat)
     {
@@ -184,66 +238,10 @@ void copy_rvec_to_nbat_real(const int *a, int na, int na_round,
             }
             break;
         case nbatX4:
-            j = atom_to_x_index<c_packX4>(a0);
-            c = a0 & (c_packX4-1);
-            for (i = 0; i < na; i++)
-            {
-                xnb[j+XX*c_packX4] = x[a[i]][XX];
-                xnb[j+YY*c_packX4] = x[a[i]][YY];
-                xnb[j+ZZ*c_packX4] = x[a[i]][ZZ];
-                j++;
-                c++;
-                if (c == c_packX4)
-                {
-                    j += (DIM-1)*c_packX4;
-                    c  = 0;
-                }
-            }
-            /* Complete the partially filled last cell with zeros */
-            for (; i < na_round; i++)
-            {
-                xnb[j+XX*c_packX4] = farAway;
-                xnb[j+YY*c_packX4] = farAway;
-                xnb[j+ZZ*c_packX4] = farAway;
-                j++;
-                c++;
-                if (c == c_packX4)
-                {
-                    j += (DIM-1)*c_packX4;
-                    c  = 0;
-                }
-            }
+            copy_rvec_to_nbat_real_packed<c_packX4>(a, na, na_round, x, xnb, a0, farAway);
             break;
         case nbatX8:
-            j = atom_to_x_index<c_packX8>(a0);
-            c = a0 & (c_packX8 - 1);
-            for (i = 0; i < na; i++)
-            {
-                xnb[j+XX*c_packX8] = x[a[i]][XX];
-                xnb[j+YY*c_packX8] = x[a[i]][YY];
-                xnb[j+ZZ*c_packX8] = x[a[i]][ZZ];
-                j++;
-                c++;
-                if (c == c_packX8)
-                {
-                    j += (DIM-1)*c_packX8;
-                    c  = 0;
-                }
-            }
-            /* Complete the partially filled last cell with zeros */
-            for (; i < na_round; i++)
-            {
-                xnb[j+XX*c_packX8] = farAway;
-                xnb[j+YY*c_packX8] = farAway;
-                xnb[j+ZZ*c_packX8] = farAway;
-                j++;
-                c++;
-                if (c == c_packX8)
-                {
-                    j += (DIM-1)*c_packX8;
-                    c  = 0;
-                }
-            }
+            copy_rvec_to_nbat_real_packed<c_packX8>(a, na, na_round, x, xnb, a0, farAway);
             break;
         default:
             gmx_incons("Unsupported nbnxn_atomdata_t format");
@@ -1049,45 +1047,40 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet     &gridSet,
     else
     {
         const int nth = gmx_omp_nthreads_get(emntPairsearch);
-#pragma omp parallel for num_threads(nth) schedule(static)
-        for (int th = 0; th < nth; th++)
-        {
-            try
-            {
-                for (int g = gridBegin; g < gridEnd; g++)
-                {
-                    const Nbnxm::Grid  &grid       = gridSet.grids()[g];
-                    const int           numCellsXY = grid.numColumns();
-
-                    const int           cxy0 = (numCellsXY* th      + nth - 1)/nth;
-                    const int           cxy1 = (numCellsXY*(th + 1) + nth - 1)/nth;
-
-                    for (int cxy = cxy0; cxy < cxy1; cxy++)
-                    {
-                        const int na  = grid.numAtomsInColumn(cxy);
-                        const int ash = grid.firstAtomInColumn(cxy);
-
-                        int       na_fill;
-                        if (g == 0 && FillLocal)
-                        {
-                            na_fill = grid.paddedNumAtomsInColumn(cxy);
-                        }
-                        else
-                        {
-                            /* We fill only the real particle locations.
-                             * We assume the filling entries at the end have been
-                             * properly set before during pair-list generation.
-                             */
-                            na_fill = na;
-                        }
-                        copy_rvec_to_nbat_real(gridSet.atomIndices().data() + ash,
-                                               na, na_fill, x,
-                                               nbat->XFormat, nbat->x().data(), ash);
-                    }
-                }
-            }
-            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-        }
+        gmx::runThreadTasks(nth, [&](int th)
+                            {
+                                for (int g = gridBegin; g < gridEnd; g++)
+                                {
+                                    const Nbnxm::Grid  &grid       = gridSet.grids()[g];
+                                    const int           numCellsXY = grid.numColumns();
+
+                                    const int           cxy0 = (numCellsXY* th      + nth - 1)/nth;
+                                    const int           cxy1 = (numCellsXY*(th + 1) + nth - 1)/nth;
+
+                                    for (int cxy = cxy0; cxy < cxy1; cxy++)
+                                    {
+                                        const int na  = grid.numAtomsInColumn(cxy);
+                                        const int ash = grid.firstAtomInColumn(cxy);
+
+                                        int       na_fill;
+                                        if (g == 0 && FillLocal)
+                                        {
+                                            na_fill = grid.paddedNumAtomsInColumn(cxy);
+                                        }
+                                        else
+                                        {
+                                            /* We fill only the real particle locations.
+                                             * We assume the filling entries at the end have been
+                                             * properly set before during pair-list generation.
+                                             */
+                                            na_fill = na;
+                                        }
+                                        copy_rvec_to_nbat_real(gridSet.atomIndices().data() + ash,
+                                                               na, na_fill, x,
+                                                               nbat->XFormat, nbat->x().data(), ash);
+                                    }
+                                }
+                            });
     }
 }
 
@@ -1386,55 +1379,50 @@ static void nbnxn_atomdata_add_nbat_f_to_f_treereduce(nbnxn_atomdata_t *nbat,
 static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbnxn_atomdata_t *nbat,
                                                      int               nth)
 {
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
-        try
-        {
-            const nbnxn_buffer_flags_t *flags;
-            int                         nfptr;
-            const real                 *fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
-
-            flags = &nbat->buffer_flags;
-
-            /* Calculate the cell-block range for our thread */
-            int b0 = (flags->nflag* th   )/nth;
-            int b1 = (flags->nflag*(th+1))/nth;
-
-            for (int b = b0; b < b1; b++)
-            {
-                int i0 =  b   *NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
-                int i1 = (b+1)*NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
-
-                nfptr = 0;
-                for (int out = 1; out < gmx::ssize(nbat->out); out++)
-                {
-                    if (bitmask_is_set(flags->flag[b], out))
-                    {
-                        fptr[nfptr++] = nbat->out[out].f.data();
-                    }
-                }
-                if (nfptr > 0)
-                {
+    gmx::runThreadTasks(nth, [&](int th)
+                        {
+                            const nbnxn_buffer_flags_t *flags;
+                            int                         nfptr;
+                            const real                 *fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
+
+                            flags = &nbat->buffer_flags;
+
+                            /* Calculate the cell-block range for our thread */
+                            int b0 = (flags->nflag* th   )/nth;
+                            int b1 = (flags->nflag*(th+1))/nth;
+
+                            for (int b = b0; b < b1; b++)
+                            {
+                                int i0 =  b   *NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
+                                int i1 = (b+1)*NBNXN_BUFFERFLAG_SIZE*nbat->fstride;
+
+                                nfptr = 0;
+                                for (int out = 1; out < gmx::ssize(nbat->out); out++)
+                                {
+                                    if (bitmask_is_set(flags->flag[b], out))
+                                    {
+                                        fptr[nfptr++] = nbat->out[out].f.data();
+                                    }
+                                }
+                                if (nfptr > 0)
+                                {
 #if GMX_SIMD
-                    nbnxn_atomdata_reduce_reals_simd
+                                    nbnxn_atomdata_reduce_reals_simd
 #else
-                    nbnxn_atomdata_reduce_reals
+                                    nbnxn_atomdata_reduce_reals
 #endif
-                        (nbat->out[0].f.data(),
-                        bitmask_is_set(flags->flag[b], 0),
-                        fptr, nfptr,
-                        i0, i1);
-                }
-                else if (!bitmask_is_set(flags->flag[b], 0))
-                {
-                    nbnxn_atomdata_clear_reals(nbat->out[0].f,
-                                               i0, i1);
-                }
-            }
-        }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-    }
+                                        (nbat->out[0].f.data(),
+                                        bitmask_is_set(flags->flag[b], 0),
+                                        fptr, nfptr,
+                                        i0, i1);
+                                }
+                                else if (!bitmask_is_set(flags->flag[b], 0))
+                                {
+                                    nbnxn_atomdata_clear_reals(nbat->out[0].f,
+                                                               i0, i1);
+                                }
+                            }
+                        });
 }
 
 /* Add the force array(s) from nbnxn_atomdata_t to f */
@@ -1491,19 +1479,14 @@ void reduceForces(nbnxn_atomdata_t          *nbat,
             nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbat, nth);
         }
     }
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
-        try
-        {
-            nbnxn_atomdata_add_nbat_f_to_f_part(gridSet, *nbat,
-                                                nbat->out[0],
-                                                a0 + ((th + 0)*na)/nth,
-                                                a0 + ((th + 1)*na)/nth,
-                                                f);
-        }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
-    }
+    gmx::runThreadTasks(nth, [&](int th)
+                        {
+                            nbnxn_atomdata_add_nbat_f_to_f_part(gridSet, *nbat,
+                                                                nbat->out[0],
+                                                                a0 + ((th + 0)*na)/nth,
+                                                                a0 + ((th + 1)*na)/nth,
+                                                                f);
+                        });
 }
 
 void nbnxn_atomdata_add_nbat_fshift_to_fshift(const nbnxn_atomdata_t *nbat,
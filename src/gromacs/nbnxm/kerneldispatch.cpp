@@ -54,6 +54,7 @@
 #include "gromacs/nbnxm/nbnxm_simd.h"
 #include "gromacs/nbnxm/kernels_reference/kernel_gpu_ref.h"
 #include "gromacs/simd/simd.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/real.h"
 
@@ -145,6 +146,7 @@ reduceGroupEnergySimdBuffers(int                       numGroups,
  * \param[in]     clearF        Enum that tells if to clear the force output buffer
  * \param[out]    vCoulomb      Output buffer for Coulomb energies
  * \param[out]    vVdw          Output buffer for Van der Waals energies
+ * \param[in]     overlapTasks  Extra tasks to run in the same thread team, can be nullptr
  */
 static void
 nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
@@ -155,7 +157,8 @@ nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
                  int                             forceFlags,
                  int                             clearF,
                  real                           *vCoulomb,
-                 real                           *vVdw)
+                 real                           *vVdw,
+                 const Nbnxm::OverlapTasks      *overlapTasks)
 {
 
     int                      coulkt;
@@ -237,12 +240,8 @@ nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
 
     gmx::ArrayRef<const NbnxnPairlistCpu> pairlists = pairlistSet.cpuLists();
 
-    int gmx_unused                        nthreads = gmx_omp_nthreads_get(emntNonbonded);
-#pragma omp parallel for schedule(static) num_threads(nthreads)
-    for (int nb = 0; nb < pairlists.ssize(); nb++)
+    auto computeList = [&](int nb)
     {
-        // Presently, the kernels do not call C++ code that can throw,
-        // so no need for a try/catch pair in this OpenMP region.
         nbnxn_atomdata_output_t *out = &nbat->out[nb];
 
         if (clearF == enbvClearFYes)
@@ -382,6 +381,41 @@ nbnxn_kernel_cpu(const PairlistSet              &pairlistSet,
                 }
             }
         }
+    };
+
+    const int  numLists = pairlists.ssize();
+    int gmx_unused nthreads = gmx_omp_nthreads_get(emntNonbonded);
+    if (overlapTasks == nullptr || overlapTasks->numTasks == 0)
+    {
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+        for (int nb = 0; nb < numLists; nb++)
+        {
+            // Presently, the kernels do not call C++ code that can throw,
+            // so no need for a try/catch pair in this OpenMP region.
+            computeList(nb);
+        }
+    }
+    else
+    {
+        /* The lists come first, as they are the largest tasks. Threads
+         * that finish their list early pick up the overlap tasks.
+         */
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+        for (int task = 0; task < numLists + overlapTasks->numTasks; task++)
+        {
+            try
+            {
+                if (task < numLists)
+                {
+                    computeList(task);
+                }
+                else
+                {
+                    overlapTasks->runTask(task - numLists);
+                }
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
     }
 
     if (forceFlags & GMX_FORCE_ENERGY)
@@ -456,8 +490,11 @@ nonbonded_verlet_t::dispatchNonbondedKernel(Nbnxm::InteractionLocality iLocality
                                             int                        clearF,
                                             const t_forcerec          &fr,
                                             gmx_enerdata_t            *enerd,
-                                            t_nrnb                    *nrnb)
+                                            t_nrnb                    *nrnb,
+                                            const Nbnxm::OverlapTasks *overlapTasks)
 {
+    GMX_ASSERT(overlapTasks == nullptr || !(useGpu() || emulateGpu()), "Overlap tasks are only supported with CPU kernels");
+
     const PairlistSet &pairlistSet = pairlistSets().pairlistSet(iLocality);
 
     switch (kernelSetup().kernelType)
@@ -475,7 +512,8 @@ nonbonded_verlet_t::dispatchNonbondedKernel(Nbnxm::InteractionLocality iLocality
                              enerd->grpp.ener[egCOULSR].data(),
                              fr.bBHAM ?
                              enerd->grpp.ener[egBHAMSR].data() :
-                             enerd->grpp.ener[egLJSR].data());
+                             enerd->grpp.ener[egLJSR].data(),
+                             overlapTasks);
             break;
 
         case Nbnxm::KernelType::Gpu8x8x8:
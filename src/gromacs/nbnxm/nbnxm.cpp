@@ -189,6 +189,12 @@ void nonbonded_verlet_t::changePairlistRadii(real rlistOuter,
     pairlistSets_->changePairlistRadii(rlistOuter, rlistInner);
 }
 
+void nonbonded_verlet_t::changeDynamicPruningInterval(int  nstlistPrune,
+                                                      real rlistInner)
+{
+    pairlistSets_->changeDynamicPruningInterval(nstlistPrune, rlistInner);
+}
+
 void
 nonbonded_verlet_t::atomdata_init_copy_x_to_nbat_x_gpu(const Nbnxm::AtomLocality        locality)
 {
@@ -98,6 +98,7 @@
 #ifndef GMX_NBNXM_NBNXM_H
 #define GMX_NBNXM_NBNXM_H
 
+#include <functional>
 #include <memory>
 
 #include "gromacs/math/vectypes.h"
@@ -179,6 +180,20 @@ struct KernelSetup
  */
 const char *lookup_kernel_name(Nbnxm::KernelType kernelType);
 
+/*! \brief Independent tasks to run in the thread team of the CPU non-bonded kernels
+ *
+ * These tasks are scheduled dynamically together with the pairlists,
+ * so other force work, e.g. the listed forces, overlaps with the
+ * non-bonded work without a separate parallel region and barrier.
+ */
+struct OverlapTasks
+{
+    //! The number of tasks
+    int                      numTasks = 0;
+    //! Runs the task with the index passed, should be thread safe
+    std::function<void(int)> runTask;
+};
+
 } // namespace Nbnxm
 
 /*! \brief Flag to tell the nonbonded kernels whether to clear the force output buffers */
@@ -271,14 +286,19 @@ struct nonbonded_verlet_t
         //! Dispatches the dynamic pruning kernel for GPU lists
         void dispatchPruneKernelGpu(int64_t step);
 
-        //! \brief Executes the non-bonded kernel of the GPU or launches it on the GPU
+        /*! \brief Executes the non-bonded kernel of the GPU or launches it on the GPU
+         *
+         * With CPU kernels, the tasks in \p overlapTasks, when not nullptr,
+         * are run in the same thread team as the non-bonded kernels.
+         */
         void dispatchNonbondedKernel(Nbnxm::InteractionLocality  iLocality,
                                      const interaction_const_t  &ic,
                                      int                         forceFlags,
                                      int                         clearF,
                                      const t_forcerec           &fr,
                                      gmx_enerdata_t             *enerd,
-                                     t_nrnb                     *nrnb);
+                                     t_nrnb                     *nrnb,
+                                     const Nbnxm::OverlapTasks  *overlapTasks = nullptr);
 
         //! Executes the non-bonded free-energy kernel, always runs on the CPU
         void dispatchFreeEnergyKernel(Nbnxm::InteractionLocality  iLocality,
@@ -313,6 +333,10 @@ struct nonbonded_verlet_t
         void changePairlistRadii(real rlistOuter,
                                  real rlistInner);
 
+        //! Changes the dynamic pruning interval and the inner radius, should only be called at search steps
+        void changeDynamicPruningInterval(int  nstlistPrune,
+                                          real rlistInner);
+
         // TODO: Make all data members private
     public:
         //! All data related to the pair lists
@@ -56,12 +56,15 @@
 #include "gromacs/hardware/cpuinfo.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/calc_verletbuf.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/state.h"
+#include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/nbnxm/nbnxm_geometry.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
@@ -243,6 +246,10 @@ void increaseNstlist(FILE *fp, t_commrec *cr,
     ListSetupType      listType  = (useOrEmulateGpuForNonbondeds ? ListSetupType::Gpu : ListSetupType::CpuSimdWhenSupported);
     VerletbufListSetup listSetup = verletbufGetSafeListSetup(listType);
 
+    /* This is called before the thread counts are set, on every
+     * thread-MPI rank, so we estimate the buffers serially.
+     */
+
     /* Allow rlist to make the list a given factor larger than the list
      * would be with the reference value for nstlist (10).
      */
@@ -250,7 +257,7 @@ void increaseNstlist(FILE *fp, t_commrec *cr,
     ir->nstlist  = nbnxnReferenceNstlist;
     const real rlistWithReferenceNstlist =
         calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1,
-                             -1, listSetup);
+                             -1, listSetup, 1);
     ir->nstlist  = nstlist_prev;
 
     /* Determine the pair list size increase due to zero interactions */
@@ -275,7 +282,7 @@ void increaseNstlist(FILE *fp, t_commrec *cr,
 
         /* Set the pair-list buffer size in ir */
         rlist_new =
-            calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1, -1, listSetup);
+            calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1, -1, listSetup, 1);
 
         /* Does rlist fit in the box? */
         bBox = (gmx::square(rlist_new) < max_cutoff2(ir->ePBC, box));
@@ -410,7 +417,7 @@ setDynamicPairlistPruningParameters(const t_inputrec             *ir,
         listParams->rlistInner   =
             calcVerletBufferSize(*mtop, det(box), *ir,
                                  tunedNstlistPrune, listLifetime,
-                                 -1, listSetup);
+                                 -1, listSetup, gmx_omp_nthreads_get(emntDefault));
 
         /* On the GPU we apply the dynamic pruning in a rolling fashion
          * every c_nbnxnGpuRollingListPruningInterval steps,
@@ -529,7 +536,8 @@ void setupDynamicPairlistPruning(const gmx::MDLogger       &mdlog,
             static_assert(c_nbnxnDynamicListPruningMinLifetime % c_nbnxnGpuRollingListPruningInterval == 0,
                           "c_nbnxnDynamicListPruningMinLifetime sets the starting value for nstlistPrune, which should be divisible by the rolling pruning interval for efficiency reasons.");
 
-            // TODO: Use auto-tuning to determine nstlistPrune
+            // TODO: Use auto-tuning to determine nstlistPrune with GPU lists,
+            // with CPU lists DynamicPruningTuner tunes it during the run
             listParams->nstlistPrune = c_nbnxnDynamicListPruningMinLifetime;
         }
 
@@ -577,14 +585,14 @@ void setupDynamicPairlistPruning(const gmx::MDLogger       &mdlog,
         const VerletbufListSetup listSetup1x1 = { 1, 1 };
         const real               rlistOuter   =
             calcVerletBufferSize(*mtop, det(box), *ir, ir->nstlist, ir->nstlist - 1,
-                                 -1, listSetup1x1);
+                                 -1, listSetup1x1, gmx_omp_nthreads_get(emntDefault));
         real                     rlistInner   = rlistOuter;
         if (listParams->useDynamicPruning)
         {
             int listLifeTime = listParams->nstlistPrune - (useGpuList ? 0 : 1);
             rlistInner =
                 calcVerletBufferSize(*mtop, det(box), *ir, listParams->nstlistPrune, listLifeTime,
-                                     -1, listSetup1x1);
+                                     -1, listSetup1x1, gmx_omp_nthreads_get(emntDefault));
         }
 
         mesg += gmx::formatString("At tolerance %g kJ/mol/ps per atom, equivalent classical 1x1 list would be:\n",
@@ -602,3 +610,217 @@ void setupDynamicPairlistPruning(const gmx::MDLogger       &mdlog,
 
     GMX_LOG(mdlog.info).asParagraph().appendText(mesg);
 }
+
+/*! \brief The smallest dynamic pruning interval the tuning will try
+ *
+ * Pruning every step is nearly always slower than using no pruning.
+ */
+static const int c_minTunedNstlistPrune = 2;
+
+/*! \brief The number of nstlist intervals to measure per pruning interval
+ *
+ * We use the lowest cycle count of the measurements to reduce noise.
+ */
+static const int c_numMeasurementsPerNstlistPrune = 2;
+
+/*! \brief Returns the inner list radius for pruning interval \p nstlistPrune
+ *
+ * The buffer is determined with the cut-off's in \p ir. As in the PME
+ * load balancing, which can have changed the cut-off's in \p ic,
+ * we keep the buffer sizes fixed when the cut-off's have been changed.
+ *
+ * \param[in] ir            The input parameter record
+ * \param[in] mtop          The global topology
+ * \param[in] box           The unit cell
+ * \param[in] ic            The nonbonded interactions constants
+ * \param[in] listParams    The list setup parameters
+ * \param[in] nstlistPrune  The dynamic pruning interval
+ */
+static real innerListRadius(const t_inputrec          &ir,
+                            const gmx_mtop_t          &mtop,
+                            const matrix               box,
+                            const interaction_const_t &ic,
+                            const PairlistParams      &listParams,
+                            int                        nstlistPrune)
+{
+    const VerletbufListSetup listSetup =
+    {
+        IClusterSizePerListType[listParams.pairlistType],
+        JClusterSizePerListType[listParams.pairlistType]
+    };
+
+    /* With dynamic pruning on the CPU we prune after updating,
+     * so the list lifetime is nstlistPrune - 1.
+     */
+    const real rlistInnerInputrec =
+        calcVerletBufferSize(mtop, det(box), ir, nstlistPrune, nstlistPrune - 1,
+                             -1, listSetup, gmx_omp_nthreads_get(emntDefault));
+    const real rlistInner         =
+        std::max(ic.rcoulomb + rlistInnerInputrec - ir.rcoulomb,
+                 ic.rvdw + rlistInnerInputrec - ir.rvdw);
+
+    return std::min(rlistInner, listParams.rlistOuter);
+}
+
+PruningIntervalSearch::PruningIntervalSearch(int minInterval,
+                                             int maxInterval,
+                                             int initialInterval) :
+    minInterval_(minInterval),
+    maxInterval_(maxInterval),
+    interval_(initialInterval),
+    bestInterval_(initialInterval),
+    direction_(-1),
+    isDone_(false),
+    costs_(maxInterval + 1, -1)
+{
+    GMX_RELEASE_ASSERT(minInterval <= initialInterval && initialInterval <= maxInterval,
+                       "The initial interval should be within the search range");
+}
+
+void PruningIntervalSearch::addCost(double cost)
+{
+    GMX_ASSERT(cost >= 0, "Costs should not be negative");
+
+    if (costs_[interval_] < 0 || cost < costs_[interval_])
+    {
+        costs_[interval_] = cost;
+    }
+}
+
+int PruningIntervalSearch::moveToNextInterval()
+{
+    GMX_ASSERT(!isDone_, "Can not continue a finished search");
+    GMX_ASSERT(costs_[interval_] >= 0, "The current interval should have been measured");
+
+    if (costs_[interval_] < costs_[bestInterval_])
+    {
+        bestInterval_ = interval_;
+    }
+
+    /* Continue in the current direction as long as the cost decreases */
+    int next = interval_ + direction_;
+    if (interval_ != bestInterval_ ||
+        next < minInterval_ || next > maxInterval_ ||
+        costs_[next] >= 0)
+    {
+        /* Search towards longer intervals, starting from the best */
+        next = bestInterval_ + 1;
+        if (direction_ > 0 || next > maxInterval_ || costs_[next] >= 0)
+        {
+            next    = bestInterval_;
+            isDone_ = true;
+        }
+        direction_ = 1;
+    }
+    interval_ = next;
+
+    return interval_;
+}
+
+DynamicPruningTuner::DynamicPruningTuner(const nonbonded_verlet_t &nbv,
+                                         bool                      isAllowed) :
+    isActive_(false),
+    numMeasurements_(0),
+    prevNumCounts_(0),
+    prevCycles_(0)
+{
+    const PairlistParams &listParams = nbv.pairlistSets().params();
+
+    if (!isAllowed ||
+        nbv.useGpu() ||
+        listParams.pairlistType == PairlistType::HierarchicalNxN ||
+        !listParams.useDynamicPruning ||
+        getenv("GMX_NSTLIST_DYNAMICPRUNING") != nullptr ||
+        getenv("GMX_DISABLE_DYNAMICPRUNING_TUNING") != nullptr)
+    {
+        return;
+    }
+
+    /* Pruning with an interval of lifetime or longer is useless */
+    const int minNstlistPrune = c_minTunedNstlistPrune;
+    const int maxNstlistPrune = listParams.lifetime - 1;
+    if (listParams.nstlistPrune < minNstlistPrune || listParams.nstlistPrune > maxNstlistPrune ||
+        minNstlistPrune == maxNstlistPrune)
+    {
+        return;
+    }
+
+    search_   = std::make_unique<PruningIntervalSearch>(minNstlistPrune, maxNstlistPrune,
+                                                        listParams.nstlistPrune);
+    isActive_ = true;
+}
+
+void DynamicPruningTuner::tune(const gmx::MDLogger       &mdlog,
+                               const t_inputrec          &ir,
+                               const gmx_mtop_t          &mtop,
+                               const matrix               box,
+                               const interaction_const_t &ic,
+                               gmx_wallcycle             *wcycle,
+                               nonbonded_verlet_t        *nbv)
+{
+    if (!isActive_)
+    {
+        return;
+    }
+
+    /* Without cycle counters we can not measure, so we keep the interval */
+    if (wcycle == nullptr)
+    {
+        isActive_ = false;
+        return;
+    }
+
+    int    numCounts;
+    double cycles;
+    wallcycle_get(wcycle, ewcFORCE, &numCounts, &cycles);
+
+    /* We ignore the first interval, which includes allocation overhead,
+     * and intervals that do not consist of exactly nstlist force calls,
+     * which happens when the cycle counters are reset or when we were
+     * not called every search step (e.g. during PME load balancing).
+     */
+    const bool isValidMeasurement = (prevNumCounts_ > 0 &&
+                                     numCounts - prevNumCounts_ == ir.nstlist);
+    const double intervalCycles   = cycles - prevCycles_;
+    prevNumCounts_                = numCounts;
+    prevCycles_                   = cycles;
+
+    if (!isValidMeasurement)
+    {
+        return;
+    }
+
+    if (debug)
+    {
+        fprintf(debug, "Dynamic pruning tuning: nstlistPrune %d rlistInner %.3f cycles %.3f M\n",
+                search_->interval(), nbv->pairlistInnerRadius(), intervalCycles*1e-6);
+    }
+
+    search_->addCost(intervalCycles);
+    numMeasurements_++;
+    if (numMeasurements_ < c_numMeasurementsPerNstlistPrune)
+    {
+        return;
+    }
+    numMeasurements_ = 0;
+
+    const int next = search_->moveToNextInterval();
+    isActive_      = !search_->isDone();
+
+    const PairlistParams &listParams = nbv->pairlistSets().params();
+    if (next != listParams.nstlistPrune)
+    {
+        nbv->changeDynamicPruningInterval(next,
+                                          innerListRadius(ir, mtop, box, ic, listParams, next));
+    }
+
+    if (!isActive_)
+    {
+        const real interactionCutoff = std::max(ic.rcoulomb, ic.rvdw);
+
+        std::string mesg = "Tuned the dynamic pair-list pruning using the force calculation timings:\n";
+        mesg += formatListSetup("inner", nbv->pairlistSets().params().nstlistPrune, ir.nstlist,
+                                nbv->pairlistInnerRadius(), interactionCutoff);
+        GMX_LOG(mdlog.info).asParagraph().appendText(mesg);
+    }
+}
@@ -48,7 +48,11 @@
 
 #include <stdio.h>
 
+#include <memory>
+#include <vector>
+
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
 
 namespace gmx
 {
@@ -57,7 +61,9 @@ class MDLogger;
 }
 
 struct gmx_mtop_t;
+struct gmx_wallcycle;
 struct interaction_const_t;
+class nonbonded_verlet_t;
 struct PairlistParams;
 struct t_commrec;
 struct t_inputrec;
@@ -96,4 +102,137 @@ void setupDynamicPairlistPruning(const gmx::MDLogger       &mdlog,
                                  const interaction_const_t *ic,
                                  PairlistParams            *listParams);
 
+/*! \libinternal
+ * \brief Searches for the dynamic pruning interval with the lowest cost
+ *
+ * The search starts at the initial interval and moves towards shorter
+ * intervals as long as the cost decreases. It then moves towards longer
+ * intervals, starting from the lowest-cost interval, again as long as
+ * the cost decreases. Intervals are limited to the range passed to the
+ * constructor. When the cost of an interval is measured several times,
+ * the lowest value is used.
+ */
+class PruningIntervalSearch
+{
+    public:
+        /*! \brief Constructor
+         *
+         * \param[in] minInterval      The shortest interval to try
+         * \param[in] maxInterval      The longest interval to try
+         * \param[in] initialInterval  The interval to start with, should be in the range above
+         */
+        PruningIntervalSearch(int minInterval,
+                              int maxInterval,
+                              int initialInterval);
+
+        //! Returns the interval to measure, or the lowest-cost interval when the search is done
+        int interval() const
+        {
+            return interval_;
+        }
+
+        //! Returns whether the search is done
+        bool isDone() const
+        {
+            return isDone_;
+        }
+
+        //! Records a cost measurement, which should not be negative, for the current interval
+        void addCost(double cost);
+
+        /*! \brief Moves to the next interval and returns it
+         *
+         * When there is no interval left that could lower the cost,
+         * the search is done and the lowest-cost interval is returned.
+         * Should only be called after a cost was added for the current
+         * interval and while the search is not done.
+         */
+        int moveToNextInterval();
+
+    private:
+        //! The shortest interval to try
+        int                 minInterval_;
+        //! The longest interval to try
+        int                 maxInterval_;
+        //! The interval currently measured
+        int                 interval_;
+        //! The lowest-cost interval so far
+        int                 bestInterval_;
+        //! The search direction, -1 or 1
+        int                 direction_;
+        //! Whether the search is done
+        bool                isDone_;
+        //! The lowest cost for each interval, -1 when not measured
+        std::vector<double> costs_;
+};
+
+/*! \libinternal
+ * \brief Tunes the dynamic pruning interval of CPU pair lists at run time
+ *
+ * The dynamic pruning interval nstlistPrune set up at startup is based
+ * on an estimate of the relative cost of the pruning and the non-bonded
+ * kernels. This class measures the force calculation cycles over nstlist
+ * steps for different intervals, searching from the initial interval
+ * towards lower and higher values, and selects the fastest.
+ * For each interval the inner list radius is determined from the Verlet
+ * buffer tolerance, so the drift tolerance is always respected.
+ * nstlist and the outer list radius are not changed. Each rank tunes
+ * its own interval, as the optimum depends on the hardware.
+ * Tuning requires cycle counters, it is turned off when they are not
+ * available.
+ */
+class DynamicPruningTuner
+{
+    public:
+        /*! \brief Constructor
+         *
+         * Tuning is only active when dynamic pruning is used with CPU
+         * pair lists, the user did not set the pruning interval and
+         * \p isAllowed is true.
+         *
+         * \param[in] nbv        The non-bonded setup
+         * \param[in] isAllowed  Whether tuning is allowed by the caller
+         */
+        DynamicPruningTuner(const nonbonded_verlet_t &nbv,
+                            bool                      isAllowed);
+
+        //! Returns whether tuning is still in progress
+        bool isActive() const
+        {
+            return isActive_;
+        }
+
+        /*! \brief Measures the cost of the current interval and moves to the next interval
+         *
+         * Should be called at search steps, before the force calculation.
+         *
+         * \param[in]     mdlog   MD logger
+         * \param[in]     ir      The input parameter record
+         * \param[in]     mtop    The global topology
+         * \param[in]     box     The unit cell
+         * \param[in]     ic      The nonbonded interactions constants
+         * \param[in]     wcycle  The cycle counters, tuning stops when nullptr
+         * \param[in,out] nbv     The non-bonded setup
+         */
+        void tune(const gmx::MDLogger       &mdlog,
+                  const t_inputrec          &ir,
+                  const gmx_mtop_t          &mtop,
+                  const matrix               box,
+                  const interaction_const_t &ic,
+                  gmx_wallcycle             *wcycle,
+                  nonbonded_verlet_t        *nbv);
+
+    private:
+        //! Whether we are still tuning
+        bool                                   isActive_;
+        //! The search over the intervals, using cycles over nstlist steps as cost
+        std::unique_ptr<PruningIntervalSearch> search_;
+        //! The number of measurements done with the current interval
+        int                                    numMeasurements_;
+        //! The force cycle counter count at the previous call
+        int                                    prevNumCounts_;
+        //! The force cycles at the previous call
+        double                                 prevCycles_;
+};
+
 #endif /* NBNXM_PAIRLIST_TUNING_H */
@@ -118,6 +118,14 @@ class PairlistSets
             params_.rlistInner = rlistInner;
         }
 
+        //! Changes the dynamic pruning interval and the inner radius
+        void changeDynamicPruningInterval(int  nstlistPrune,
+                                          real rlistInner)
+        {
+            params_.nstlistPrune = nstlistPrune;
+            params_.rlistInner   = rlistInner;
+        }
+
         //! Returns the pair-list set for the given locality
         const PairlistSet &pairlistSet(Nbnxm::InteractionLocality iLocality) const
         {
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the search of the dynamic pruning interval
+ *
+ * \ingroup module_nbnxm
+ */
+#include "gmxpre.h"
+
+#include "gromacs/nbnxm/pairlist_tuning.h"
+
+#include <functional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Runs a search with costs given by \p cost, measured \p numMeasurements times per interval
+ *
+ * Returns the measured intervals in order, followed by the final interval.
+ */
+std::vector<int> runSearch(PruningIntervalSearch              *search,
+                           const std::function<double(int)> &cost,
+                           int                                numMeasurements = 1)
+{
+    std::vector<int> intervals;
+    while (!search->isDone())
+    {
+        intervals.push_back(search->interval());
+        for (int m = 0; m < numMeasurements; m++)
+        {
+            search->addCost(cost(search->interval()) + m);
+        }
+        search->moveToNextInterval();
+    }
+    intervals.push_back(search->interval());
+
+    return intervals;
+}
+
+TEST(PruningIntervalSearchTest, FindsMinimumBelowInitialInterval)
+{
+    PruningIntervalSearch search(2, 10, 6);
+    const auto            intervals = runSearch(&search, [](int i) { return (i - 3)*(i - 3); });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 5, 4, 3, 2, 3 }));
+}
+
+TEST(PruningIntervalSearchTest, FindsMinimumAboveInitialInterval)
+{
+    PruningIntervalSearch search(2, 10, 4);
+    const auto            intervals = runSearch(&search, [](int i) { return (i - 7)*(i - 7); });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 4, 3, 5, 6, 7, 8, 7 }));
+}
+
+TEST(PruningIntervalSearchTest, StopsAtInitialIntervalWhenNeighborsAreSlower)
+{
+    PruningIntervalSearch search(2, 10, 5);
+    const auto            intervals = runSearch(&search, [](int i) { return (i - 5)*(i - 5); });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 5, 4, 6, 5 }));
+}
+
+TEST(PruningIntervalSearchTest, StaysWithinLowerBound)
+{
+    PruningIntervalSearch search(2, 10, 4);
+    const auto            intervals = runSearch(&search, [](int i) { return i; });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 4, 3, 2, 2 }));
+}
+
+TEST(PruningIntervalSearchTest, StaysWithinUpperBound)
+{
+    PruningIntervalSearch search(2, 5, 4);
+    const auto            intervals = runSearch(&search, [](int i) { return 100 - i; });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 4, 3, 5, 5 }));
+}
+
+TEST(PruningIntervalSearchTest, StartsAtLowerBound)
+{
+    PruningIntervalSearch search(2, 10, 2);
+    const auto            intervals = runSearch(&search, [](int i) { return (i - 4)*(i - 4); });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 2, 3, 4, 5, 4 }));
+}
+
+TEST(PruningIntervalSearchTest, StartsAtUpperBound)
+{
+    PruningIntervalSearch search(2, 10, 10);
+    const auto            intervals = runSearch(&search, [](int i) { return 100 - i; });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 10, 9, 10 }));
+}
+
+TEST(PruningIntervalSearchTest, UsesLowestOfRepeatedMeasurements)
+{
+    PruningIntervalSearch search(2, 10, 6);
+    /* The repeated measurements are higher, so the result should not change */
+    const auto            intervals = runSearch(&search, [](int i) { return (i - 3)*(i - 3); }, 3);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 5, 4, 3, 2, 3 }));
+}
+
+TEST(PruningIntervalSearchTest, HandlesSingleIntervalRange)
+{
+    PruningIntervalSearch search(3, 3, 3);
+    const auto            intervals = runSearch(&search, [](int i) { return i; });
+
+    EXPECT_EQ(intervals, std::vector<int>({ 3, 3 }));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -42,6 +42,8 @@
 
 #include "gromacs/random/threefry.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "gromacs/utility/exceptions.h"
@@ -223,6 +225,27 @@ TEST_F(ThreeFry2x64Test, Discard)
 }
 
 
+TEST_F(ThreeFry2x64Test, FirstResultsMatchRestart)
+{
+    gmx::ThreeFry2x64<10>  rngA(123456, gmx::RandomDomain::Other);
+    gmx::ThreeFry2x64<10>  rngB(123456, gmx::RandomDomain::Other);
+
+    std::vector<uint64_t>  counters = { 0, 1, 2, 3, 5, 8, 13, 21, 34, 55, 1000000 };
+    std::vector<uint64_t>  results(counters.size());
+
+    rngA.generateFirstResults(42, counters.data(), static_cast<int>(counters.size()), results.data());
+    for (size_t i = 0; i < counters.size(); i++)
+    {
+        rngB.restart(42, counters[i]);
+        EXPECT_EQ(rngB(), results[i]);
+    }
+
+    // Highest 10 bits of counter reserved for the internal counter.
+    counters[3] = 0xFFFFFFFFFFFFFFFF;
+    EXPECT_THROW_GMX(rngA.generateFirstResults(42, counters.data(), static_cast<int>(counters.size()), results.data()),
+                     gmx::InternalError);
+}
+
 TEST_F(ThreeFry2x64Test, InvalidCounter)
 {
     gmx::ThreeFry2x64<10> rngA(123456, gmx::RandomDomain::Other);
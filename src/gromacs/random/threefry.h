@@ -350,7 +350,7 @@ class ThreeFry2x64General
          *  \return Input value rotated 'bits' left.
          */
         result_type
-        rotLeft(result_type i, unsigned int bits)
+        rotLeft(result_type i, unsigned int bits) const
         {
             return (i << bits) | (i >> (std::numeric_limits<result_type>::digits-bits));
         }
@@ -369,7 +369,7 @@ class ThreeFry2x64General
          */
         counter_type
         generateBlock(const counter_type &key,
-                      const counter_type &ctr)
+                      const counter_type &ctr) const
         {
             const unsigned int  rotations[] = {16, 42, 12, 31, 16, 32, 24, 21};
             counter_type        x           = ctr;
@@ -580,6 +580,46 @@ class ThreeFry2x64General
             return block_[index_++];
         }
 
+        /*! \brief Generate the first random value of many streams at once
+         *
+         *  For each i, \p result[i] is identical to the first value returned
+         *  by operator() after calling restart(ctr0, ctr1[i]). The state of
+         *  the engine is not changed.
+         *
+         *  This is useful when only a few random bits are needed per counter
+         *  value, e.g. a few normal distributed numbers per atom with the
+         *  atom index as counter. Since there are no dependencies between
+         *  the different counters, the compiler can vectorize the
+         *  encryption rounds over the counters.
+         *
+         *  \param ctr0        First word of the counters.
+         *  \param ctr1        Second word of the counters, \p numCounters values.
+         *  \param numCounters The number of counters.
+         *  \param result      The first random value for each counter.
+         *
+         *  \throws InternalError if any of the highest bits that are reserved
+         *         for the internal part of the counter are set.
+         */
+        void
+        generateFirstResults(uint64_t        ctr0,
+                             const uint64_t *ctr1,
+                             int             numCounters,
+                             result_type    *result) const
+        {
+            for (int i = 0; i < numCounters; i++)
+            {
+                counter_type counter = {{ctr0, ctr1[i]}};
+                if (!internal::highBitCounter::checkAndClear<result_type, 2, internalCounterBits>(&counter))
+                {
+                    GMX_THROW(InternalError("High bits of counter are reserved for the internal stream counter."));
+                }
+            }
+            for (int i = 0; i < numCounters; i++)
+            {
+                result[i] = generateBlock(key_, {{ctr0, ctr1[i]}})[0];
+            }
+        }
+
         /*! \brief Skip next n random numbers
          *
          *  Moves the internal random stream for the give key/counter value
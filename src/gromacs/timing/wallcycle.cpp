@@ -127,6 +127,7 @@ static const char *wcsn[ewcsNR] =
     "Listed buffer ops.",
     "Nonbonded pruning",
     "Nonbonded F",
+    "Nonbonded+bonded F",
     "Launch NB GPU tasks",
     "Launch Bonded GPU tasks",
     "Launch PME GPU tasks",
@@ -134,6 +135,8 @@ static const char *wcsn[ewcsNR] =
     "NB X buffer ops.",
     "NB F buffer ops.",
     "Clear force buffer",
+    "Thread team start",
+    "Thread team barrier",
     "Test subcounter",
 };
 
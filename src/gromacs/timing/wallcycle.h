@@ -73,6 +73,7 @@ enum {
     ewcsLISTED_BUF_OPS,
     ewcsNONBONDED_PRUNING,
     ewcsNONBONDED,
+    ewcsNONBONDED_AND_LISTED,
     ewcsLAUNCH_GPU_NONBONDED,
     ewcsLAUNCH_GPU_BONDED,
     ewcsLAUNCH_GPU_PME,
@@ -80,6 +81,8 @@ enum {
     ewcsNB_X_BUF_OPS,
     ewcsNB_F_BUF_OPS,
     ewcsCLEAR_FORCE_BUFFER,
+    ewcsTHREAD_TEAM_START,
+    ewcsTHREAD_TEAM_BARRIER,
     ewcsTEST,
     ewcsNR
 };
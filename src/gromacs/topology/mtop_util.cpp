@@ -558,14 +558,11 @@ t_block gmx_mtop_global_cgs(const gmx_mtop_t *mtop)
     return cgs_gl;
 }
 
-static void atomcat(t_atoms *dest, const t_atoms *src, int copies,
-                    int maxres_renum, int *maxresnr)
+/*! \brief Sets the flags for what data is present in \p dest after
+ * appending \p src to it, with \p destnr atoms present in \p dest */
+static void atomcatFlags(t_atoms *dest, int destnr, const t_atoms *src)
 {
-    int i, j, l, size;
-    int srcnr  = src->nr;
-    int destnr = dest->nr;
-
-    if (dest->nr == 0)
+    if (destnr == 0)
     {
         dest->haveMass    = src->haveMass;
         dest->haveType    = src->haveType;
@@ -581,30 +578,19 @@ static void atomcat(t_atoms *dest, const t_atoms *src, int copies,
         dest->haveBState  = dest->haveBState  && src->haveBState;
         dest->havePdbInfo = dest->havePdbInfo && src->havePdbInfo;
     }
+}
 
-    if (srcnr)
-    {
-        size = destnr+copies*srcnr;
-        srenew(dest->atom, size);
-        srenew(dest->atomname, size);
-        if (dest->haveType)
-        {
-            srenew(dest->atomtype, size);
-            if (dest->haveBState)
-            {
-                srenew(dest->atomtypeB, size);
-            }
-        }
-        if (dest->havePdbInfo)
-        {
-            srenew(dest->pdbinfo, size);
-        }
-    }
-    if (src->nres)
-    {
-        size = dest->nres+copies*src->nres;
-        srenew(dest->resinfo, size);
-    }
+/*! \brief Appends \p copies copies of \p src to \p dest
+ *
+ * The arrays in \p dest should already be allocated for the final size
+ * and the flags of \p dest set with atomcatFlags() for all sources.
+ */
+static void atomcat(t_atoms *dest, const t_atoms *src, int copies,
+                    int maxres_renum, int *maxresnr)
+{
+    int i, j, l;
+    int srcnr  = src->nr;
+    int destnr = dest->nr;
 
     /* residue information */
     for (l = dest->nres, j = 0; (j < copies); j++, l += src->nres)
@@ -668,6 +654,40 @@ t_atoms gmx_mtop_global_atoms(const gmx_mtop_t *mtop)
 
     init_t_atoms(&atoms, 0, FALSE);
 
+    /* Determine the final sizes and flags, so we can allocate
+     * all arrays once instead of growing them for every block.
+     */
+    int numAtoms    = 0;
+    int numResidues = 0;
+    for (const gmx_molblock_t &molb : mtop->molblock)
+    {
+        const t_atoms &src = mtop->moltype[molb.type].atoms;
+        atomcatFlags(&atoms, numAtoms, &src);
+        numAtoms    += molb.nmol*src.nr;
+        numResidues += molb.nmol*src.nres;
+    }
+    if (numAtoms > 0)
+    {
+        snew(atoms.atom, numAtoms);
+        snew(atoms.atomname, numAtoms);
+        if (atoms.haveType)
+        {
+            snew(atoms.atomtype, numAtoms);
+            if (atoms.haveBState)
+            {
+                snew(atoms.atomtypeB, numAtoms);
+            }
+        }
+        if (atoms.havePdbInfo)
+        {
+            snew(atoms.pdbinfo, numAtoms);
+        }
+    }
+    if (numResidues > 0)
+    {
+        snew(atoms.resinfo, numResidues);
+    }
+
     int maxresnr = mtop->maxresnr;
     for (const gmx_molblock_t &molb : mtop->molblock)
     {
@@ -41,9 +41,13 @@
  */
 #include "gmxpre.h"
 
+#include <algorithm>
+
 #include <gtest/gtest.h>
 
+#include "gromacs/topology/atoms.h"
 #include "gromacs/topology/mtop_util.h"
+#include "gromacs/utility/smalloc.h"
 
 namespace gmx
 {
@@ -101,6 +105,52 @@ TEST(MtopTest, Operators)
     EXPECT_FALSE(it == otherIt);
 }
 
+TEST(MtopTest, GlobalAtomsCoversAllBlocks)
+{
+    gmx_mtop_t mtop;
+    // Two molecule types, with 3 atoms in 1 residue and 2 atoms in 2 residues
+    mtop.moltype.resize(2);
+    for (int type = 0; type < 2; type++)
+    {
+        t_atoms  &atoms       = mtop.moltype[type].atoms;
+        const int numAtoms    = 3 - type;
+        const int numResidues = 1 + type;
+        init_t_atoms(&atoms, numAtoms, FALSE);
+        snew(atoms.resinfo, numResidues);
+        atoms.nres     = numResidues;
+        atoms.haveMass = TRUE;
+        for (int i = 0; i < numAtoms; i++)
+        {
+            atoms.atom[i].m      = 10*type + i;
+            atoms.atom[i].resind = std::min(i, numResidues - 1);
+        }
+    }
+    mtop.molblock.resize(3);
+    const int types[] = { 0, 1, 0 };
+    const int nmols[] = { 2, 3, 1 };
+    for (int b = 0; b < 3; b++)
+    {
+        mtop.molblock[b].type = types[b];
+        mtop.molblock[b].nmol = nmols[b];
+    }
+    mtop.natoms       = 2*3 + 3*2 + 1*3;
+    mtop.maxres_renum = 0;
+    gmx_mtop_finalize(&mtop);
+
+    t_atoms atoms = gmx_mtop_global_atoms(&mtop);
+    EXPECT_EQ(15, atoms.nr);
+    EXPECT_EQ(2*1 + 3*2 + 1*1, atoms.nres);
+    EXPECT_TRUE(atoms.haveMass);
+    const real expectedMass[]   = { 0, 1, 2, 0, 1, 2, 10, 11, 10, 11, 10, 11, 0, 1, 2 };
+    const int  expectedResind[] = { 0, 0, 0, 1, 1, 1, 2, 3, 4, 5, 6, 7, 8, 8, 8 };
+    for (int i = 0; i < atoms.nr; i++)
+    {
+        EXPECT_EQ(expectedMass[i], atoms.atom[i].m);
+        EXPECT_EQ(expectedResind[i], atoms.atom[i].resind);
+    }
+    done_atom(&atoms);
+}
+
 }  // namespace
 
 }  // namespace gmx
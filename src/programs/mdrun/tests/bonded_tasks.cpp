@@ -0,0 +1,182 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2019, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests that computing the bonded forces as tasks of the non-bonded
+ * kernel gives the same results as computing them separately
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include "config.h"
+
+#include <cstdlib>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/simulationdatabase.h"
+#include "testutils/testasserts.h"
+
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "mdruncomparison.h"
+#include "moduletest.h"
+#include "trajectorycomparison.h"
+#include "trajectoryreader.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Sets or unsets the environment variable that disables the bonded tasks
+void setDisableBondedTasks(bool disable)
+{
+    const char *name = "GMX_DISABLE_BONDED_TASKS";
+#if GMX_NATIVE_WINDOWS
+    _putenv_s(name, disable ? "1" : "");
+#else
+    if (disable)
+    {
+        setenv(name, "1", 1);
+    }
+    else
+    {
+        unsetenv(name);
+    }
+#endif
+}
+
+//! Test fixture for computing the bonded forces as tasks
+class MdrunBondedTasksTest : public MdrunTestFixture,
+                             public ::testing::WithParamInterface<std::string>
+{
+};
+
+TEST_P(MdrunBondedTasksTest, ForcesAndEnergiesMatchSeparateBondeds)
+{
+    const std::string simulationName = GetParam();
+    SCOPED_TRACE(formatString("Comparing bonded forces computed as tasks and separately "
+                              "for simulation '%s'", simulationName.c_str()));
+
+    const int numRanksAvailable = getNumberOfTestMpiRanks();
+    if (!isNumberOfPpRanksSupported(simulationName, numRanksAvailable))
+    {
+        fprintf(stdout, "Test system '%s' cannot run with %d ranks.\n"
+                "The supported numbers are: %s\n",
+                simulationName.c_str(), numRanksAvailable,
+                reportNumbersOfPpRanksSupported(simulationName).c_str());
+        return;
+    }
+
+    auto mdpFieldValues = prepareMdpFieldValues(simulationName.c_str(), "md", "no", "no");
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    const std::string tasksTrajectoryFileName    = fileManager_.getTemporaryFilePath("tasks.trr");
+    const std::string tasksEdrFileName           = fileManager_.getTemporaryFilePath("tasks.edr");
+    const std::string separateTrajectoryFileName = fileManager_.getTemporaryFilePath("separate.trr");
+    const std::string separateEdrFileName        = fileManager_.getTemporaryFilePath("separate.edr");
+
+    for (bool disableBondedTasks : { false, true })
+    {
+        runner_.fullPrecisionTrajectoryFileName_ = (disableBondedTasks ? separateTrajectoryFileName : tasksTrajectoryFileName);
+        runner_.edrFileName_                     = (disableBondedTasks ? separateEdrFileName : tasksEdrFileName);
+        setDisableBondedTasks(disableBondedTasks);
+        CommandLine caller;
+        caller.append("mdrun");
+        // The bonded tasks are only used with CPU non-bonded kernels
+        caller.addOption("-nb", "cpu");
+        const int   exitCode = runner_.callMdrun(caller);
+        setDisableBondedTasks(false);
+        ASSERT_EQ(0, exitCode);
+    }
+
+    /* The bonded thread output is reduced in the same order in both
+     * cases, so we expect (nearly) identical results.
+     */
+    EnergyTolerances energiesToMatch
+    {{
+         {
+             interaction_function[F_EPOT].longname, relativeToleranceAsPrecisionDependentUlp(10.0, 24, 40)
+         },
+     }};
+    auto namesOfEnergiesToMatch = getKeys(energiesToMatch);
+    FramePairManager<EnergyFrameReader, EnergyFrame>
+         energyManager(openEnergyFileToReadFields(separateEdrFileName, namesOfEnergiesToMatch),
+                  openEnergyFileToReadFields(tasksEdrFileName, namesOfEnergiesToMatch));
+    energyManager.compareAllFramePairs([&energiesToMatch](const EnergyFrame &reference, const EnergyFrame &test)
+                                       {
+                                           compareEnergyFrames(reference, test, energiesToMatch);
+                                       });
+
+    TrajectoryFrameMatchSettings trajectoryMatchSettings {
+        true, true, true, true, true, true
+    };
+    TrajectoryTolerances         trajectoryTolerances {
+        defaultRealTolerance(),                                               // box
+        relativeToleranceAsFloatingPoint(1.0, 1.0e-3),                        // positions
+        relativeToleranceAsFloatingPoint(1.0, 1.0e-3),                        // velocities
+        relativeToleranceAsFloatingPoint(100.0, GMX_DOUBLE ? 1.0e-7 : 1.0e-5) // forces
+    };
+    FramePairManager<TrajectoryFrameReader, TrajectoryFrame>
+    trajectoryManager(std::make_unique<TrajectoryFrameReader>(separateTrajectoryFileName),
+                      std::make_unique<TrajectoryFrameReader>(tasksTrajectoryFileName));
+    trajectoryManager.compareAllFramePairs([&trajectoryMatchSettings, &trajectoryTolerances](const TrajectoryFrame &reference, const TrajectoryFrame &test)
+                                           {
+                                               compareTrajectoryFrames(reference, test, trajectoryMatchSettings, trajectoryTolerances);
+                                           });
+}
+
+INSTANTIATE_TEST_CASE_P(WithCpuNonbondeds, MdrunBondedTasksTest,
+                            ::testing::Values("alanine_vsite_vacuo", "alanine_vsite_solvated"));
+
+} // namespace
+} // namespace test
+} // namespace gmx